@@ -0,0 +1,811 @@
+// フレーム単位の処理（瞳孔検出・前処理・EAR）を単体で計測するベンチマーク
+// カメラ不要。生成画像または録画ファイルを入力に、ROIサイズごとの
+// ns/frame と allocations/frame を CSV または JSON で出力する
+// --accuracy では生成画像の正解位置に対する瞳孔検出の誤差を比較する
+// --blink-agreement では合成映像で開き具合の算出方法ごとの瞬き検出を比較する
+#include "BlinkDetector.h"
+#include "GazeCalibration.h"
+#include "GazeEstimator.h"
+#include "MultiStreamTracker.h"
+#include "PreprocessCache.h"
+#include "PupilTracker.h"
+#include "ReplaySource.h"
+#include "SyntheticEyeGenerator.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// ヒープ確保の計測
+// glibc では malloc 系を差し替えて OpenCV 内部（cv::fastMalloc）の確保も数える。
+// それ以外の環境では operator new のみを数える。
+// ---------------------------------------------------------------------------
+namespace {
+
+std::atomic<uint64_t> allocation_count(0);
+std::atomic<uint64_t> allocation_bytes(0);
+
+inline void countAllocation(size_t bytes) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+}
+
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(size_t size) {
+    countAllocation(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    countAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    countAllocation(size);
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    countAllocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    countAllocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    countAllocation(size);
+    void* ptr = __libc_memalign(alignment, size);
+    if (!ptr) {
+        return ENOMEM;
+    }
+    *out = ptr;
+    return 0;
+}
+
+void free(void* ptr) {
+    __libc_free(ptr);
+}
+}
+#else
+void* operator new(size_t size) {
+    countAllocation(size);
+    if (void* ptr = std::malloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+#endif
+
+// GazeEstimator / BlinkDetector の内部処理へのアクセス
+class EyeTrackerBench {
+public:
+    static cv::Point2f houghCircles(GazeEstimator& estimator, PreprocessCache& cache) {
+        return estimator.findPupilUsingHoughCircles(cache);
+    }
+    
+    static cv::Point2f gradient(GazeEstimator& estimator, PreprocessCache& cache) {
+        return estimator.findPupilUsingGradient(cache);
+    }
+    
+    static GradientPupilLocator& gradientLocator(GazeEstimator& estimator) {
+        return estimator.gradient_locator;
+    }
+    
+    static cv::Point2f contours(GazeEstimator& estimator, PreprocessCache& cache) {
+        return estimator.findPupilUsingContours(cache);
+    }
+    
+    static const cv::Mat& preprocess(GazeEstimator& estimator, PreprocessCache& cache) {
+        return estimator.preprocessEyeImage(cache);
+    }
+    
+    static size_t eyeContour(BlinkDetector& detector, PreprocessCache& cache) {
+        return detector.extractEyeContour(cache).size();
+    }
+};
+
+namespace {
+
+struct BenchOptions {
+    int iterations = 200;
+    int warmup = 20;
+    int threads = 1;
+    int accuracy_samples = 0; // 0 なら速度計測
+    int blink_frames = 0;     // 0 なら速度計測
+    std::vector<int> stream_counts; // 空なら速度計測
+    int stream_frames = 300;
+    int workers = 0;                // 0 ならコア数
+    std::string input_path;
+    std::string format = "csv";
+    std::string output_path;
+    std::vector<cv::Size> sizes = {
+        cv::Size(64, 32), cv::Size(128, 64), cv::Size(160, 120),
+        cv::Size(320, 240), cv::Size(640, 480)
+    };
+};
+
+struct BenchResult {
+    std::string kernel;
+    cv::Size size;
+    int iterations;
+    double mean_ns;
+    double p50_ns;
+    double p99_ns;
+    double allocations_per_frame;
+    double bytes_per_frame;
+};
+
+// ピラミッド探索の段ごとの処理時間の集計
+struct LevelTimingSum {
+    int samples = 0;
+    std::array<double, MatArena::MAX_PYRAMID_LEVELS + 1> total_ms = {};
+    
+    void add(const PyramidTiming& timing) {
+        samples++;
+        for (int level = 0; level <= timing.levels; level++) {
+            total_ms[level] += timing.level_ms[level];
+        }
+    }
+};
+
+// 段ごとの平均を標準エラーに出して集計をリセットする（CSV/JSON の出力とは分ける）
+void printLevelTiming(const std::string& name, int levels, const cv::Size& size, LevelTimingSum& sum) {
+    if (sum.samples == 0) {
+        return;
+    }
+    std::cerr << name << " " << size.width << "x" << size.height << ":";
+    for (int level = levels; level >= 0; level--) {
+        std::cerr << " level" << level << "=" << sum.total_ms[level] / sum.samples << "ms";
+    }
+    std::cerr << std::endl;
+    sum = LevelTimingSum();
+}
+
+// 1回分の計測対象: setup は計測外（前提となるキャッシュの準備など）
+struct Kernel {
+    std::string name;
+    std::function<void(PreprocessCache&, const cv::Mat&)> setup;
+    std::function<void(PreprocessCache&)> run;
+};
+
+std::vector<cv::Mat> loadRecordedFrames(const std::string& path, size_t max_frames) {
+    std::vector<cv::Mat> frames;
+    ReplaySource replay;
+    if (!replay.open(path, ReplayPacing::AsFastAsPossible)) {
+        return frames;
+    }
+    
+    cv::Mat frame;
+    FrameSource::Clock::time_point timestamp;
+    while (frames.size() < max_frames && replay.read(frame, timestamp)) {
+        frames.push_back(frame.clone());
+    }
+    return frames;
+}
+
+std::vector<cv::Mat> makeInputs(const std::vector<cv::Mat>& recorded, const cv::Size& size) {
+    const size_t INPUT_COUNT = 16;
+    std::vector<cv::Mat> inputs;
+    
+    if (!recorded.empty()) {
+        for (const auto& frame : recorded) {
+            cv::Mat resized;
+            cv::resize(frame, resized, size, 0, 0, cv::INTER_AREA);
+            inputs.push_back(resized);
+        }
+        return inputs;
+    }
+    
+    // 開いた目を中心に、閉じかけの目も混ぜる
+    SyntheticEyeGenerator generator(size.area());
+    SyntheticEyeLabel label;
+    for (size_t i = 0; i < INPUT_COUNT; i++) {
+        cv::Mat image;
+        generator.render(generator.randomParams(size), image, label);
+        inputs.push_back(image);
+    }
+    return inputs;
+}
+
+BenchResult runKernel(const Kernel& kernel, const std::vector<cv::Mat>& inputs,
+                      const cv::Size& size, const BenchOptions& options) {
+    PreprocessCache cache;
+    std::vector<double> samples;
+    samples.reserve(options.iterations);
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    
+    for (int i = 0; i < options.warmup + options.iterations; i++) {
+        const cv::Mat& input = inputs[i % inputs.size()];
+        kernel.setup(cache, input);
+        
+        uint64_t count_before = allocation_count.load(std::memory_order_relaxed);
+        uint64_t bytes_before = allocation_bytes.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        
+        kernel.run(cache);
+        
+        auto end = std::chrono::steady_clock::now();
+        uint64_t count_after = allocation_count.load(std::memory_order_relaxed);
+        uint64_t bytes_after = allocation_bytes.load(std::memory_order_relaxed);
+        
+        if (i >= options.warmup) {
+            samples.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+            allocations += count_after - count_before;
+            bytes += bytes_after - bytes_before;
+        }
+    }
+    
+    BenchResult result;
+    result.kernel = kernel.name;
+    result.size = size;
+    result.iterations = options.iterations;
+    
+    double total = 0;
+    for (double sample : samples) {
+        total += sample;
+    }
+    result.mean_ns = total / samples.size();
+    
+    std::sort(samples.begin(), samples.end());
+    result.p50_ns = samples[samples.size() / 2];
+    result.p99_ns = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+    result.allocations_per_frame = static_cast<double>(allocations) / options.iterations;
+    result.bytes_per_frame = static_cast<double>(bytes) / options.iterations;
+    return result;
+}
+
+struct AccuracyResult {
+    std::string locator;
+    cv::Size size;
+    int samples;
+    double found_rate;
+    double mean_error_px;
+    double p95_error_px;
+    double mean_diff_vs_hough_px; // ハフ変換と両方見つかったフレームでの差
+    double max_diff_vs_hough_px;
+};
+
+AccuracyResult summarizeAccuracy(const std::string& locator, const cv::Size& size,
+                                 const std::vector<cv::Point2f>& found,
+                                 const std::vector<cv::Point2f>& truth,
+                                 const std::vector<cv::Point2f>& hough) {
+    AccuracyResult result;
+    result.locator = locator;
+    result.size = size;
+    result.samples = static_cast<int>(truth.size());
+    
+    std::vector<double> errors;
+    double diff_total = 0;
+    double diff_max = 0;
+    int diff_count = 0;
+    for (size_t i = 0; i < truth.size(); i++) {
+        if (found[i].x < 0) {
+            continue;
+        }
+        errors.push_back(cv::norm(found[i] - truth[i]));
+        if (hough[i].x >= 0) {
+            double diff = cv::norm(found[i] - hough[i]);
+            diff_total += diff;
+            diff_max = std::max(diff_max, diff);
+            diff_count++;
+        }
+    }
+    
+    result.found_rate = truth.empty() ? 0 : static_cast<double>(errors.size()) / truth.size();
+    result.mean_error_px = 0;
+    result.p95_error_px = 0;
+    if (!errors.empty()) {
+        double total = 0;
+        for (double error : errors) {
+            total += error;
+        }
+        result.mean_error_px = total / errors.size();
+        std::sort(errors.begin(), errors.end());
+        result.p95_error_px = errors[std::min(errors.size() - 1, errors.size() * 95 / 100)];
+    }
+    result.mean_diff_vs_hough_px = diff_count > 0 ? diff_total / diff_count : 0;
+    result.max_diff_vs_hough_px = diff_max;
+    return result;
+}
+
+// 開いた目の生成画像で、ハフ変換・勾配法・ピラミッド探索の検出位置を正解と比べる
+std::vector<AccuracyResult> runAccuracy(GazeEstimator& estimator, GazeEstimator& pyramid_half,
+                                        GazeEstimator& pyramid_quarter, const cv::Size& size, int samples) {
+    SyntheticEyeGenerator generator(size.area() + 1);
+    SyntheticEyeLabel label;
+    PreprocessCache cache;
+    cv::Mat image;
+    std::vector<cv::Point2f> truth, hough, gradient, half, quarter;
+    
+    while (static_cast<int>(truth.size()) < samples) {
+        generator.render(generator.randomParams(size, 0.0), image, label);
+        if (!label.pupil_visible) {
+            continue;
+        }
+        truth.push_back(label.pupil_center);
+        cache.reset(image);
+        hough.push_back(EyeTrackerBench::houghCircles(estimator, cache));
+        gradient.push_back(EyeTrackerBench::gradient(estimator, cache));
+        half.push_back(EyeTrackerBench::houghCircles(pyramid_half, cache));
+        quarter.push_back(EyeTrackerBench::houghCircles(pyramid_quarter, cache));
+    }
+    
+    return {
+        summarizeAccuracy("houghCircles", size, hough, truth, hough),
+        summarizeAccuracy("gradient", size, gradient, truth, hough),
+        summarizeAccuracy("pyramid/L1", size, half, truth, hough),
+        summarizeAccuracy("pyramid/L2", size, quarter, truth, hough),
+    };
+}
+
+struct BlinkAgreementResult {
+    std::string metric;
+    cv::Size size;
+    uint64_t frames;
+    double mean_ns;
+    size_t blinks;
+    size_t label_blinks;
+    size_t matched_label_blinks;  // 正解の瞬きのうち検出できたもの
+    size_t matched_ear_blinks;    // 輪郭 EAR で検出した瞬きのうち同じく検出したもの
+    double closed_frame_agreement; // 閾値未満かどうかが輪郭 EAR と一致したフレームの割合
+};
+
+// a の各瞬きについて、b に前後 tolerance フレーム以内の瞬きがある数
+size_t countMatches(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b, uint64_t tolerance) {
+    size_t matched = 0;
+    for (uint64_t frame : a) {
+        for (uint64_t other : b) {
+            if (frame + tolerance >= other && other + tolerance >= frame) {
+                matched++;
+                break;
+            }
+        }
+    }
+    return matched;
+}
+
+// 瞬き（ダブル瞬きを含む）入りの合成映像で、輪郭 EAR と投影プロファイルの瞬き検出を比べる
+// 正解は生成時のまぶたランドマークから求めた EAR を同じ BlinkDetector に通したもの
+// "/tracked" は EyeTracker と同じく PupilTracker の追跡状態と合わせて判定したもの
+// （小窓で瞳孔を確認したフレームでは EAR の低下を無視する経路を含む）
+std::vector<BlinkAgreementResult> runBlinkAgreement(const cv::Size& size, int frames) {
+    const uint64_t MATCH_TOLERANCE_FRAMES = 3;
+    const int VARIANTS = 4;
+    const OpennessMetric metrics[VARIANTS] = { OpennessMetric::ContourEAR, OpennessMetric::ProjectionProfile,
+                                               OpennessMetric::ContourEAR, OpennessMetric::ProjectionProfile };
+    const bool tracked[VARIANTS] = { false, false, true, true };
+    const char* names[VARIANTS] = { "contourEAR", "projectionProfile",
+                                    "contourEAR/tracked", "projectionProfile/tracked" };
+    
+    SyntheticEyeSource source(size, 30.0, frames);
+    BlinkDetector label_detector;
+    BlinkDetector detectors[VARIANTS];
+    PreprocessCache caches[VARIANTS];
+    PupilTracker pupil_trackers[VARIANTS];
+    GazeEstimator estimators[VARIANTS];
+    double total_ns[VARIANTS] = { 0, 0, 0, 0 };
+    uint64_t agreeing_frames[VARIANTS] = { 0, 0, 0, 0 };
+    std::vector<uint64_t> label_blinks;
+    std::vector<uint64_t> blinks[VARIANTS];
+    
+    for (int v = 0; v < VARIANTS; v++) {
+        detectors[v].setOpennessMetric(metrics[v]);
+    }
+    
+    cv::Mat frame;
+    FrameSource::Clock::time_point timestamp;
+    uint64_t index = 0;
+    for (; source.read(frame, timestamp); index++) {
+        if (label_detector.detectBlink(source.lastLabel().ear)) {
+            label_blinks.push_back(index);
+        }
+        
+        bool closed[VARIANTS];
+        for (int v = 0; v < VARIANTS; v++) {
+            caches[v].reset(frame);
+            auto start = std::chrono::steady_clock::now();
+            FrameAnalysis analysis;
+            analysis.timestamp = timestamp;
+            if (tracked[v]) {
+                analysis.pupil_center = pupil_trackers[v].track(caches[v], timestamp, estimators[v]);
+                analysis.pupil_found = analysis.pupil_center.x >= 0 && analysis.pupil_center.y >= 0;
+                analysis.pupil_track_state = pupil_trackers[v].state();
+                analysis.pupil_window_confirmed = pupil_trackers[v].confirmedByWindow();
+            }
+            analysis.ear = detectors[v].calculateOpenness(caches[v]);
+            total_ns[v] += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            
+            closed[v] = analysis.ear < 0.25;
+            bool blink = tracked[v] ? detectors[v].detectBlink(analysis)
+                                    : detectors[v].detectBlink(analysis.ear);
+            if (blink) {
+                blinks[v].push_back(index);
+            }
+        }
+        for (int v = 0; v < VARIANTS; v++) {
+            if (closed[v] == closed[0]) {
+                agreeing_frames[v]++;
+            }
+        }
+    }
+    
+    std::vector<BlinkAgreementResult> results;
+    for (int v = 0; v < VARIANTS; v++) {
+        BlinkAgreementResult result;
+        result.metric = names[v];
+        result.size = size;
+        result.frames = index;
+        result.mean_ns = index > 0 ? total_ns[v] / index : 0;
+        result.blinks = blinks[v].size();
+        result.label_blinks = label_blinks.size();
+        result.matched_label_blinks = countMatches(label_blinks, blinks[v], MATCH_TOLERANCE_FRAMES);
+        result.matched_ear_blinks = countMatches(blinks[0], blinks[v], MATCH_TOLERANCE_FRAMES);
+        result.closed_frame_agreement = index > 0 ? static_cast<double>(agreeing_frames[v]) / index : 0;
+        results.push_back(result);
+    }
+    return results;
+}
+
+// 合成映像のストリームを streams 本同時に流し、共有プールでの合計スループットと公平性を測る
+MultiStreamReport runStreams(const cv::Size& size, int streams, int frames, int workers) {
+    MultiStreamTracker tracker(static_cast<size_t>(workers));
+    for (int i = 0; i < streams; i++) {
+        tracker.addSession("synthetic" + std::to_string(i),
+                           std::make_unique<SyntheticEyeSource>(size, 30.0, frames, 0x5eed + i),
+                           std::make_unique<RecordingKeyBackend>());
+    }
+    // セッションのコマンドモード・キー送信のログが CSV に混ざらないよう、計測中は標準出力を捨てる
+    std::streambuf* stdout_buffer = std::cout.rdbuf(nullptr);
+    tracker.run();
+    std::cout.rdbuf(stdout_buffer);
+    std::cout.clear();
+    return tracker.report();
+}
+
+void writeStreamsCsv(std::ostream& out, const std::vector<std::pair<cv::Size, MultiStreamReport>>& results) {
+    out << "streams,width,height,workers,frames,seconds,total_fps,min_stream_fps,fairness,"
+        << "pool_wait_p99_ms,latency_p99_ms\n";
+    for (const auto& entry : results) {
+        const MultiStreamReport& r = entry.second;
+        uint64_t frames = 0;
+        double min_fps = r.streams.empty() ? 0.0 : r.streams.front().fps;
+        double wait_p99 = 0.0;
+        double latency_p99 = 0.0;
+        for (const auto& stream : r.streams) {
+            frames += stream.frames;
+            min_fps = std::min(min_fps, stream.fps);
+            wait_p99 = std::max(wait_p99, stream.pool_wait_p99_ms);
+            latency_p99 = std::max(latency_p99, stream.latency_p99_ms);
+        }
+        out << r.streams.size() << ',' << entry.first.width << ',' << entry.first.height << ','
+            << r.workers << ',' << frames << ',' << r.seconds << ',' << r.total_fps << ','
+            << min_fps << ',' << r.fairness << ',' << wait_p99 << ',' << latency_p99 << '\n';
+    }
+}
+
+void writeBlinkAgreementCsv(std::ostream& out, const std::vector<BlinkAgreementResult>& results) {
+    out << "metric,width,height,frames,mean_ns,blinks,label_blinks,matched_label_blinks,"
+        << "matched_ear_blinks,closed_frame_agreement_vs_ear\n";
+    for (const auto& r : results) {
+        out << r.metric << ',' << r.size.width << ',' << r.size.height << ',' << r.frames << ','
+            << static_cast<long long>(r.mean_ns) << ',' << r.blinks << ',' << r.label_blinks << ','
+            << r.matched_label_blinks << ',' << r.matched_ear_blinks << ','
+            << r.closed_frame_agreement << '\n';
+    }
+}
+
+void writeAccuracyCsv(std::ostream& out, const std::vector<AccuracyResult>& results) {
+    out << "locator,width,height,samples,found_rate,mean_err_px,p95_err_px,mean_diff_vs_hough_px,max_diff_vs_hough_px\n";
+    for (const auto& r : results) {
+        out << r.locator << ',' << r.size.width << ',' << r.size.height << ','
+            << r.samples << ',' << r.found_rate << ',' << r.mean_error_px << ','
+            << r.p95_error_px << ',' << r.mean_diff_vs_hough_px << ',' << r.max_diff_vs_hough_px << '\n';
+    }
+}
+
+void writeCsv(std::ostream& out, const std::vector<BenchResult>& results) {
+    out << "kernel,width,height,iterations,mean_ns,p50_ns,p99_ns,allocs_per_frame,bytes_per_frame\n";
+    for (const auto& r : results) {
+        out << r.kernel << ',' << r.size.width << ',' << r.size.height << ','
+            << r.iterations << ',' << static_cast<long long>(r.mean_ns) << ','
+            << static_cast<long long>(r.p50_ns) << ',' << static_cast<long long>(r.p99_ns) << ','
+            << r.allocations_per_frame << ',' << r.bytes_per_frame << '\n';
+    }
+}
+
+void writeJson(std::ostream& out, const std::vector<BenchResult>& results) {
+    out << "{\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        out << "    {\"kernel\": \"" << r.kernel << "\", \"width\": " << r.size.width
+            << ", \"height\": " << r.size.height << ", \"iterations\": " << r.iterations
+            << ", \"mean_ns\": " << static_cast<long long>(r.mean_ns)
+            << ", \"p50_ns\": " << static_cast<long long>(r.p50_ns)
+            << ", \"p99_ns\": " << static_cast<long long>(r.p99_ns)
+            << ", \"allocs_per_frame\": " << r.allocations_per_frame
+            << ", \"bytes_per_frame\": " << r.bytes_per_frame << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+bool parseSizes(const std::string& list, std::vector<cv::Size>& sizes) {
+    sizes.clear();
+    size_t begin = 0;
+    while (begin < list.size()) {
+        size_t end = list.find(',', begin);
+        std::string item = list.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+        size_t x = item.find('x');
+        if (x == std::string::npos) {
+            return false;
+        }
+        sizes.emplace_back(std::stoi(item.substr(0, x)), std::stoi(item.substr(x + 1)));
+        if (end == std::string::npos) {
+            break;
+        }
+        begin = end + 1;
+    }
+    return !sizes.empty();
+}
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --iterations <n>       timed iterations per kernel and size (default 200)\n"
+              << "  --warmup <n>           untimed iterations before measuring (default 20)\n"
+              << "  --sizes <WxH,...>      ROI sizes (default 64x32,128x64,160x120,320x240,640x480)\n"
+              << "  --input <video|dir>    use recorded frames instead of generated ones\n"
+              << "  --threads <n>          OpenCV worker threads (default 1)\n"
+              << "  --format <csv|json>    output format (default csv)\n"
+              << "  --accuracy <n>         compare pupil locators on n labelled images per size (CSV)\n"
+              << "  --blink-agreement <n>  compare openness metrics on n synthetic frames per size (CSV)\n"
+              << "  --streams <n,...>      run n synthetic streams at once on the shared worker pool (CSV)\n"
+              << "  --stream-frames <n>    frames per stream for --streams (default 300)\n"
+              << "  --workers <n>          worker pool size for --streams (default: core count)\n"
+              << "  --output <file>        write results to a file instead of stdout\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--iterations" && has_value) {
+            options.iterations = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--warmup" && has_value) {
+            options.warmup = std::max(0, std::stoi(argv[++i]));
+        } else if (arg == "--sizes" && has_value) {
+            if (!parseSizes(argv[++i], options.sizes)) {
+                std::cerr << "Invalid --sizes" << std::endl;
+                return -1;
+            }
+        } else if (arg == "--input" && has_value) {
+            options.input_path = argv[++i];
+        } else if (arg == "--threads" && has_value) {
+            options.threads = std::stoi(argv[++i]);
+        } else if (arg == "--accuracy" && has_value) {
+            options.accuracy_samples = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--blink-agreement" && has_value) {
+            options.blink_frames = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--streams" && has_value) {
+            std::string list = argv[++i];
+            for (size_t begin = 0; begin < list.size();) {
+                size_t end = list.find(',', begin);
+                options.stream_counts.push_back(std::max(1, std::stoi(list.substr(begin, end - begin))));
+                begin = end == std::string::npos ? list.size() : end + 1;
+            }
+        } else if (arg == "--stream-frames" && has_value) {
+            options.stream_frames = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--workers" && has_value) {
+            options.workers = std::max(0, std::stoi(argv[++i]));
+        } else if (arg == "--format" && has_value) {
+            options.format = argv[++i];
+        } else if (arg == "--output" && has_value) {
+            options.output_path = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : -1;
+        }
+    }
+    
+    cv::setNumThreads(options.threads);
+    
+    std::vector<cv::Mat> recorded;
+    if (!options.input_path.empty()) {
+        recorded = loadRecordedFrames(options.input_path, 64);
+        if (recorded.empty()) {
+            std::cerr << "No frames read from " << options.input_path << std::endl;
+            return -1;
+        }
+    }
+    
+    GazeEstimator estimator;
+    BlinkDetector detector;
+    std::cerr << "gradient locator kernel: "
+              << GradientPupilLocator::kernelName(EyeTrackerBench::gradientLocator(estimator).activeKernel())
+              << std::endl;
+    
+    std::ofstream file;
+    if (!options.output_path.empty()) {
+        file.open(options.output_path);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open " << options.output_path << std::endl;
+            return -1;
+        }
+    }
+    std::ostream& out = options.output_path.empty() ? std::cout : file;
+    
+    if (options.blink_frames > 0) {
+        std::vector<BlinkAgreementResult> agreement;
+        for (const auto& size : options.sizes) {
+            for (const auto& result : runBlinkAgreement(size, options.blink_frames)) {
+                agreement.push_back(result);
+            }
+        }
+        writeBlinkAgreementCsv(out, agreement);
+        return 0;
+    }
+    
+    if (!options.stream_counts.empty()) {
+        std::vector<std::pair<cv::Size, MultiStreamReport>> streams;
+        for (const auto& size : options.sizes) {
+            for (int count : options.stream_counts) {
+                streams.emplace_back(size, runStreams(size, count, options.stream_frames, options.workers));
+            }
+        }
+        writeStreamsCsv(out, streams);
+        return 0;
+    }
+    
+    // 縮小画像で粗く探すピラミッド探索（1/2 と 1/4）
+    GazeEstimator pyramid_half;
+    GazeEstimator pyramid_quarter;
+    pyramid_half.setPyramidLevels(1);
+    pyramid_quarter.setPyramidLevels(2);
+    
+    if (options.accuracy_samples > 0) {
+        std::vector<AccuracyResult> accuracy;
+        for (const auto& size : options.sizes) {
+            for (const auto& result : runAccuracy(estimator, pyramid_half, pyramid_quarter, size,
+                                                    options.accuracy_samples)) {
+                accuracy.push_back(result);
+            }
+        }
+        writeAccuracyCsv(out, accuracy);
+        return 0;
+    }
+    
+    // SIMD の効果を見るため、スカラー実装に固定したものも並べる
+    GazeEstimator scalar_estimator;
+    EyeTrackerBench::gradientLocator(scalar_estimator).forceKernel(GradientPupilLocator::Kernel::Scalar);
+    
+    auto reset = [](PreprocessCache& cache, const cv::Mat& input) {
+        cache.reset(input);
+    };
+    
+    LevelTimingSum half_timing;
+    LevelTimingSum quarter_timing;
+    
+    // 視線の写像: 9点で当てはめた多項式の直接評価と、参照表の双線形補間を比べる（64 点ずつ）
+    GazeMapping mapping;
+    auto fitMapping = [&mapping](PreprocessCache& cache, const cv::Mat& input) {
+        cache.reset(input);
+        if (mapping.roiSize() == input.size()) {
+            return;
+        }
+        std::vector<GazeMapping::CalibrationPoint> points;
+        for (const auto& target : GazeCalibrationSession::pattern(9)) {
+            cv::Point2f pupil((0.5f + target.x * 0.3f) * input.cols, (0.5f + target.y * 0.25f) * input.rows);
+            points.push_back({pupil, target});
+        }
+        mapping.fit(points, input.size());
+    };
+    auto mappingSweep = [](const cv::Size& size, int i) {
+        return cv::Point2f((i * 37 % 64) * size.width / 64.0f, (i * 23 % 64) * size.height / 64.0f);
+    };
+    volatile float mapping_sink = 0.0f;
+    
+    // 前処理を計測から除く処理は setup でキャッシュを埋めておく
+    std::vector<Kernel> kernels = {
+        {"preprocessEyeImage", reset,
+         [&](PreprocessCache& cache) { EyeTrackerBench::preprocess(estimator, cache); }},
+        {"findPupilUsingHoughCircles",
+         [](PreprocessCache& cache, const cv::Mat& input) { cache.reset(input); cache.adaptiveBinary(); },
+         [&](PreprocessCache& cache) { EyeTrackerBench::houghCircles(estimator, cache); }},
+        // ピラミッド探索は原寸の二値化を使わないので、グレースケール化だけを計測外にする
+        {"findPupilUsingPyramid/L1",
+         [](PreprocessCache& cache, const cv::Mat& input) { cache.reset(input); cache.gray(); },
+         [&](PreprocessCache& cache) {
+             EyeTrackerBench::houghCircles(pyramid_half, cache);
+             half_timing.add(pyramid_half.lastPyramidTiming());
+         }},
+        {"findPupilUsingPyramid/L2",
+         [](PreprocessCache& cache, const cv::Mat& input) { cache.reset(input); cache.gray(); },
+         [&](PreprocessCache& cache) {
+             EyeTrackerBench::houghCircles(pyramid_quarter, cache);
+             quarter_timing.add(pyramid_quarter.lastPyramidTiming());
+         }},
+        {"findPupilUsingGradient",
+         [](PreprocessCache& cache, const cv::Mat& input) { cache.reset(input); cache.blurred(); },
+         [&](PreprocessCache& cache) { EyeTrackerBench::gradient(estimator, cache); }},
+        {"findPupilUsingGradient/scalar",
+         [](PreprocessCache& cache, const cv::Mat& input) { cache.reset(input); cache.blurred(); },
+         [&](PreprocessCache& cache) { EyeTrackerBench::gradient(scalar_estimator, cache); }},
+        {"findPupilUsingContours",
+         [](PreprocessCache& cache, const cv::Mat& input) { cache.reset(input); cache.adaptiveBinary(); },
+         [&](PreprocessCache& cache) { EyeTrackerBench::contours(estimator, cache); }},
+        {"detectPupilCenter", reset,
+         [&](PreprocessCache& cache) { estimator.detectPupilCenter(cache); }},
+        {"extractEyeContour",
+         [](PreprocessCache& cache, const cv::Mat& input) { cache.reset(input); cache.otsuBinary(); },
+         [&](PreprocessCache& cache) { EyeTrackerBench::eyeContour(detector, cache); }},
+        {"calculateEAR", reset,
+         [&](PreprocessCache& cache) { detector.calculateEAR(cache); }},
+        {"calculateProjectionOpenness", reset,
+         [&](PreprocessCache& cache) { detector.calculateProjectionOpenness(cache); }},
+        {"GazeMapping::evaluate/x64", fitMapping,
+         [&](PreprocessCache&) {
+             for (int i = 0; i < 64; i++) {
+                 mapping_sink = mapping_sink + mapping.evaluate(mappingSweep(mapping.roiSize(), i)).x;
+             }
+         }},
+        {"GazeMapping::lookup/x64", fitMapping,
+         [&](PreprocessCache&) {
+             for (int i = 0; i < 64; i++) {
+                 mapping_sink = mapping_sink + mapping.lookup(mappingSweep(mapping.roiSize(), i)).x;
+             }
+         }},
+    };
+    
+    std::vector<BenchResult> results;
+    for (const auto& size : options.sizes) {
+        std::vector<cv::Mat> inputs = makeInputs(recorded, size);
+        for (const auto& kernel : kernels) {
+            results.push_back(runKernel(kernel, inputs, size, options));
+        }
+        printLevelTiming("findPupilUsingPyramid/L1", 1, size, half_timing);
+        printLevelTiming("findPupilUsingPyramid/L2", 2, size, quarter_timing);
+    }
+    
+    if (options.format == "json") {
+        writeJson(out, results);
+    } else {
+        writeCsv(out, results);
+    }
+    
+    return 0;
+}
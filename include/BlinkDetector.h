@@ -2,32 +2,66 @@
 #define BLINKDETECTOR_H
 
 #include <opencv2/opencv.hpp>
+#include <cstdint>
 #include <vector>
 #include <chrono>
+#include "BlinkGesture.h"
+#include "FrameAnalysis.h"
+#include "PreprocessCache.h"
+
+struct BlinkConfig;
+
+// 目の開き具合の算出方法（どちらも EAR と同じく開いた目で約 0.3 以上、閉じた目で 0 に近い値）
+enum class OpennessMetric {
+    ContourEAR,        // 大津の二値化と輪郭抽出による EAR
+    ProjectionProfile  // 輝度の分散投影による開口部の縦横比
+};
 
 class BlinkDetector {
+    // 内部処理を単体で計測するため
+    friend class EyeTrackerBench;
+    
 private:
     double ear_threshold;
     int consecutive_frames;
     int frame_counter;
     bool is_blinking;
     
-    std::vector<std::chrono::steady_clock::time_point> blink_times;
-    std::chrono::steady_clock::time_point last_blink_time;
+    BlinkGestureRecognizer gesture_recognizer;
     
-    static const int MAX_BLINK_INTERVAL_MS = 800;
-    static const int MIN_BLINK_INTERVAL_MS = 100;
+    OpennessMetric openness_metric;
+    
+    // 投影プロファイルの作業バッファ（行ごと・列ごとの輝度の和と二乗和）
+    std::vector<uint32_t> column_sum;
+    std::vector<uint32_t> column_square_sum;
+    std::vector<double> row_variance;
+    std::vector<double> column_variance;
     
 public:
     BlinkDetector(double threshold = 0.25, int frames = 3);
     
+    // 閾値・間隔・開き具合の算出方法を設定から反映する（瞬きの判定中の状態は保つ）
+    void configure(const BlinkConfig& config);
+    
     double calculateEAR(const cv::Mat& eye_roi);
+    double calculateEAR(PreprocessCache& cache);
+    double calculateProjectionOpenness(PreprocessCache& cache);
+    // 選択中の方法で開き具合を求める
+    double calculateOpenness(PreprocessCache& cache);
+    
+    void setOpennessMetric(OpennessMetric metric) { openness_metric = metric; }
+    OpennessMetric getOpennessMetric() const { return openness_metric; }
+    
     bool detectBlink(const cv::Mat& eye_roi);
-    bool checkDoubleBlinkPattern();
+    bool detectBlink(double ear);
+    // 瞬きとジェスチャ（ダブル・トリプル・長い瞬き）を判定して analysis に書き込む
+    bool detectBlink(FrameAnalysis& analysis);
+    // 両目の開き具合が得られる場合のジェスチャ判定（ウインクも判定する）
+    BlinkGesture detectGesture(double left_ear, double right_ear, std::chrono::steady_clock::time_point now);
     void reset();
     
 private:
-    std::vector<cv::Point> extractEyeContour(const cv::Mat& eye_roi);
+    const std::vector<cv::Point>& extractEyeContour(PreprocessCache& cache);
     double euclideanDistance(const cv::Point& p1, const cv::Point& p2);
 };
 
@@ -0,0 +1,112 @@
+#ifndef BLINKGESTURE_H
+#define BLINKGESTURE_H
+
+#include <chrono>
+#include <cstdint>
+#include "RingBuffer.h"
+
+// 瞬きによるジェスチャ
+enum class BlinkGesture {
+    None,
+    DoubleBlink,
+    TripleBlink,
+    LongBlink,
+    LeftWink,
+    RightWink
+};
+
+// 1回の目の閉じ（瞬き・ウインク）
+struct BlinkEvent {
+    enum class Eye {
+        Both,
+        Left,
+        Right
+    };
+    
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+    Eye eye = Eye::Both;
+};
+
+// 表駆動の状態機械による瞬きジェスチャの認識
+// 毎フレーム左右の目の開閉を渡す。処理は状態表を1回引くだけの O(1) で、ヒープ確保はしない。
+// 連続した瞬きは閉じが確定した時点で通知する。2回目でダブル瞬き、続けて間隔内に3回目が来ればトリプル瞬きも通知する
+// （3回目を待たないので、ダブル瞬きに間隔分の遅れがない）。
+class BlinkGestureRecognizer {
+public:
+    static const size_t HISTORY_CAPACITY = 16;
+    using History = RingBuffer<BlinkEvent, HISTORY_CAPACITY>;
+    
+    enum State {
+        STATE_IDLE,
+        STATE_CLOSED_1,
+        STATE_OPEN_1,
+        STATE_CLOSED_2,    // ダブル瞬きを通知済み。目が開くまで待つ
+        STATE_OPEN_2,
+        STATE_CLOSED_3,    // トリプル瞬きを通知済み。目が開くまで待つ
+        STATE_LONG_HELD,   // 長い閉じを通知済み。目が開くまで待つ
+        STATE_WINK_LEFT,
+        STATE_WINK_RIGHT,
+        STATE_COUNT
+    };
+    
+    enum Input {
+        INPUT_OPEN,
+        INPUT_BOTH_CLOSED,
+        INPUT_LEFT_CLOSED,
+        INPUT_RIGHT_CLOSED,
+        INPUT_LONG_TIMEOUT, // 閉じたまま長押しの時間を超えた
+        INPUT_GAP_TIMEOUT,  // 次の瞬きが間隔内に来なかった
+        INPUT_COUNT
+    };
+
+private:
+    using Clock = std::chrono::steady_clock;
+    
+    struct Transition {
+        State next;
+        BlinkGesture emit;
+    };
+    
+    static const Transition TABLE[STATE_COUNT][INPUT_COUNT];
+    
+    int min_frames;
+    std::chrono::milliseconds long_blink;
+    std::chrono::milliseconds max_interval;
+    
+    State state;
+    Input stable_input;     // チャタリング除去後の開閉
+    Input candidate_input;  // 連続フレーム数を数えている開閉
+    int candidate_frames;
+    Clock::time_point candidate_since;
+    Clock::time_point closed_since;
+    Clock::time_point last_blink_start;
+    
+    History history;
+
+public:
+    // stable_frames: この連続フレーム数だけ同じ開閉が続いたら確定する
+    // long_duration: これ以上閉じ続けたら長い瞬き
+    // interval: 連続した瞬きとみなす、瞬きの開始どうしの最大間隔
+    BlinkGestureRecognizer(int stable_frames = 3,
+                           std::chrono::milliseconds long_duration = std::chrono::milliseconds(700),
+                           std::chrono::milliseconds interval = std::chrono::milliseconds(800));
+    
+    BlinkGesture update(bool left_closed, bool right_closed, Clock::time_point now);
+    void reset();
+    // 判定中の状態は保ったまま閾値だけ変える（設定の再読み込み用）
+    void configure(int stable_frames, std::chrono::milliseconds long_duration,
+                   std::chrono::milliseconds interval);
+    
+    State currentState() const { return state; }
+    // 直近の瞬き・ウインク（最大 HISTORY_CAPACITY 件）
+    const History& recentBlinks() const { return history; }
+    
+    static const char* gestureName(BlinkGesture gesture);
+
+private:
+    BlinkGesture apply(Input input, Clock::time_point now);
+    bool isClosedState(State s) const;
+};
+
+#endif
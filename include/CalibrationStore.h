@@ -0,0 +1,99 @@
+#ifndef CALIBRATIONSTORE_H
+#define CALIBRATIONSTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// ユーザーごとのキャリブレーション結果（ファイル上のレコードそのもの）
+// 固定長・固定幅の型だけで構成し、mmap した領域をそのまま参照できるようにする
+struct CalibrationRecord {
+    static constexpr size_t USER_NAME_SIZE = 32;
+    static constexpr size_t MAPPING_MAX_TERMS = 10;
+    static constexpr size_t MAX_CALIBRATION_POINTS = 9;
+    
+    char user[USER_NAME_SIZE];  // NUL 終端
+    int64_t updated_at;         // UNIX 時刻（秒）
+    
+    // 基準の瞳孔位置と、そのときの目領域の大きさ
+    float baseline_x;
+    float baseline_y;
+    int32_t roi_width;
+    int32_t roi_height;
+    
+    // 瞳孔位置 → 視線の写像モデル（多項式の係数。mapping_terms が 0 なら基準点からの差分を使う）
+    uint32_t mapping_terms;
+    float mapping_x[MAPPING_MAX_TERMS];
+    float mapping_y[MAPPING_MAX_TERMS];
+    // 写像を当てはめたキャリブレーション点（瞳孔位置と目標。1点の測り直しに使う）
+    uint32_t point_count;
+    float point_pupil[MAX_CALIBRATION_POINTS][2];
+    float point_target[MAX_CALIBRATION_POINTS][2];
+    
+    // 検出パラメータ（BlinkConfig・GazeConfig の該当項目）
+    float ear_threshold;
+    int32_t consecutive_frames;
+    int32_t openness_metric;
+    int32_t pupil_locator;
+    int32_t pyramid_levels;
+    
+    // キャリブレーション時の目領域の統計（照明や装着位置の変化の目安）
+    float mean_intensity;
+    float intensity_stddev;
+    float open_ear;
+    uint32_t samples;
+};
+
+static_assert(std::is_trivially_copyable<CalibrationRecord>::value,
+              "CalibrationRecord is read directly from the mapped file");
+
+// CalibrationRecord を並べたバイナリファイル
+//   ヘッダ（マジック・版・レコード長・件数・チェックサム） + CalibrationRecord × 件数
+// 読み込みは mmap で、ヘッダとチェックサムを確かめるだけ（レコードのコピーや解析はしない）。
+// 書き込みは一時ファイルに書いてから置き換えるので、途中で落ちても前のファイルが残る。
+class CalibrationStore {
+public:
+    // 2: キャリブレーション点を追加
+    static const uint32_t FORMAT_VERSION = 2;
+
+private:
+    std::string path;
+    const unsigned char* mapped_data;
+    size_t mapped_size;
+    const CalibrationRecord* records;
+    uint32_t record_count;
+#ifdef _WIN32
+    void* file_handle;
+    void* mapping_handle;
+#endif
+
+public:
+    CalibrationStore();
+    ~CalibrationStore();
+    
+    CalibrationStore(const CalibrationStore&) = delete;
+    CalibrationStore& operator=(const CalibrationStore&) = delete;
+    
+    // ファイルがなければ空のストアとして開く。壊れている・版が違う場合は false
+    bool open(const std::string& store_path);
+    void close();
+    
+    size_t profileCount() const { return record_count; }
+    const CalibrationRecord& profile(size_t index) const { return records[index]; }
+    // 見つからなければ nullptr（ポインタは次の put/close まで有効）
+    const CalibrationRecord* find(const std::string& user) const;
+    
+    // 同じユーザーのレコードを置き換える（なければ追加）してファイルに書き、開き直す
+    bool put(const CalibrationRecord& record);
+    
+    static void setUserName(CalibrationRecord& record, const std::string& user);
+
+private:
+    bool mapFile();
+    void unmapFile();
+    bool writeFile(const std::vector<CalibrationRecord>& profiles) const;
+};
+
+#endif
@@ -3,31 +3,42 @@
 
 #include <opencv2/opencv.hpp>
 #include <chrono>
+#include <memory>
+#include "FrameAnalysis.h"
+#include "KeyInjector.h"
+
+struct GazeConfig;
 
 class CommandController {
 private:
     bool command_active;
     std::chrono::steady_clock::time_point activation_time;
-    static const int COMMAND_TIMEOUT_MS = 5000;
-    
+    int command_timeout_ms;
+    // キー送信は専用スレッドに任せ、解析スレッドを止めない
+    std::unique_ptr<KeyInjector> key_injector;
+
 public:
-    CommandController();
+    // backend が nullptr ならプラットフォームの既定バックエンドを使う
+    explicit CommandController(std::unique_ptr<KeyBackend> backend = nullptr);
+    
+    // コマンドモードのタイムアウトを設定から反映する
+    void configure(const GazeConfig& config);
     
     void activateCommandMode();
+    void activateCommandMode(std::chrono::steady_clock::time_point now);
     void deactivateCommandMode();
     bool isCommandModeActive() const;
+    bool isCommandModeActive(std::chrono::steady_clock::time_point now) const;
     
-    void executeDirectionCommand(cv::Point2f direction);
+    // キーを送ったら true（コマンドモードでない・タイムアウトした場合は false）
+    bool executeDirectionCommand(cv::Point2f direction);
+    bool executeDirectionCommand(const FrameAnalysis& analysis);
     
+    KeyInjector& getKeyInjector() { return *key_injector; }
+
 private:
-    void sendArrowKey(cv::Point2f direction);
+    void sendArrowKey(cv::Point2f direction, std::chrono::steady_clock::time_point requested);
     bool isTimeoutExpired();
-    
-#ifdef _WIN32
-    void sendWindowsKey(int vk_code);
-#elif __linux__
-    void sendLinuxKey(int key_code);
-#endif
 };
 
 #endif
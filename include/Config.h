@@ -0,0 +1,54 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <string>
+#include <vector>
+#include "BlinkDetector.h"
+#include "FrameSource.h"
+#include "GazeEstimator.h"
+
+// config.xml の内容（要素がなければ既定値のまま）
+struct BlinkConfig {
+    double ear_threshold = 0.25;
+    int consecutive_frames = 3;
+    int max_blink_interval_ms = 800;
+    int long_blink_ms = 700;
+    OpennessMetric openness_metric = OpennessMetric::ContourEAR;
+};
+
+struct GazeConfig {
+    double dead_zone_radius = 0.1;
+    double min_movement_threshold = 0.05;
+    int command_timeout_ms = 5000;
+    PupilLocatorMethod pupil_locator = PupilLocatorMethod::HoughCircles;
+    int pyramid_levels = 0;
+};
+
+// カメラ設定は開くときにだけ使う（実行中の再読み込みでは変わらない）
+struct CameraConfig {
+    int width = 640;
+    int height = 480;
+    int fps = 30;
+    CapturePolicy capture_policy = CapturePolicy::LatestOnly;
+    int max_frame_age_ms = 100; // これより古いフレームは古いものとして数える（Deadline では捨てる）
+};
+
+struct EyeTrackingConfig {
+    BlinkConfig blink;
+    GazeConfig gaze;
+    CameraConfig camera;
+};
+
+// <EyeTrackingConfig> 形式の XML を読む
+// cv::FileStorage は <opencv_storage> 以外のルートを読めないため、要素とテキストだけの小さなパーサを持つ
+class ConfigLoader {
+public:
+    // 値の型・範囲が1つでも不正なら false を返し、config は変更しない
+    // 知らない要素は warnings に積んで無視する
+    static bool parse(const std::string& xml, EyeTrackingConfig& config,
+                      std::string& error, std::vector<std::string>* warnings = nullptr);
+    static bool load(const std::string& path, EyeTrackingConfig& config,
+                     std::string& error, std::vector<std::string>* warnings = nullptr);
+};
+
+#endif
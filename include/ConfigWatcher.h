@@ -0,0 +1,50 @@
+#ifndef CONFIGWATCHER_H
+#define CONFIGWATCHER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "Config.h"
+
+// 設定ファイルを監視し、書き換えられたら読み直して新しい設定を公開する
+// Linux では inotify（ディレクトリを監視するので、エディタの保存時の置き換えにも追従する）、
+// それ以外や inotify が使えない場合は更新時刻のポーリングを使う。
+// 読み込みに失敗した内容は公開せず、直前の設定を使い続ける。
+class ConfigWatcher {
+private:
+    std::string path;
+    std::shared_ptr<const EyeTrackingConfig> current;  // std::atomic_load/store で読み書きする
+    std::atomic<uint64_t> config_generation;
+    std::string last_contents;  // 監視スレッド専用
+    
+    std::thread worker;
+    std::atomic<bool> running;
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+
+public:
+    ConfigWatcher(const std::string& config_path, const EyeTrackingConfig& initial);
+    ~ConfigWatcher();
+    
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+    
+    void start();
+    void stop();
+    
+    // 新しい設定が公開されるたびに増える（フレームごとに読んでも安い）
+    uint64_t generation() const { return config_generation.load(std::memory_order_acquire); }
+    std::shared_ptr<const EyeTrackingConfig> snapshot() const { return std::atomic_load(&current); }
+
+private:
+    void watchLoop();
+    bool watchWithInotify();
+    void watchWithPolling();
+    void reload();
+};
+
+#endif
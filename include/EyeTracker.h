@@ -2,34 +2,179 @@
 #define EYETRACKER_H
 
 #include <opencv2/opencv.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include "BlinkDetector.h"
+#include "CalibrationStore.h"
+#include "GazeCursor.h"
 #include "GazeEstimator.h"
+#include "Metrics.h"
 #include "CommandController.h"
+#include "Config.h"
+#include "ConfigWatcher.h"
+#include "FramePacket.h"
+#include "GazeCalibration.h"
+#include "FramePool.h"
+#include "FrameSource.h"
+#include "ReplaySource.h"
+#include "PreprocessCache.h"
+#include "PupilTracker.h"
+#include "SPSCQueue.h"
+
+// ステージごとの滞留状況
+struct StageOccupancy {
+    size_t queued = 0;      // 入力キューの滞留数
+    size_t capacity = 0;    // 入力キューの容量
+    uint64_t processed = 0; // 処理済みフレーム数
+    uint64_t dropped = 0;   // キュー満杯で破棄したフレーム数
+};
+
+struct PipelineOccupancy {
+    StageOccupancy capture;
+    StageOccupancy analysis;
+    StageOccupancy presentation;
+};
+
+// 解析結果の表示方法
+enum class DisplayMode {
+    Window,   // 全フレームを描画して表示（既定）
+    Preview,  // 描画を間引き、最新の解析結果だけを preview_fps 以下で表示
+    Headless  // 描画もウィンドウも使わない（ディスプレイ不要）
+};
 
 class EyeTracker {
 private:
-    cv::VideoCapture cap;
+    static const size_t QUEUE_CAPACITY = 4;
+    // キュー2本分 + 各ステージで処理中の分 + 予備
+    static const size_t POOL_SIZE = QUEUE_CAPACITY * 2 + 4;
+    
+    std::unique_ptr<FrameSource> source;
     std::unique_ptr<BlinkDetector> blink_detector;
     std::unique_ptr<GazeEstimator> gaze_estimator;
     std::unique_ptr<CommandController> command_controller;
+    std::unique_ptr<GazeCursor> gaze_cursor; // ポインタモードのときだけ作る
     
-    bool is_running;
+    std::atomic<bool> is_running;
+    std::atomic<bool> capture_finished;  // 入力終端に達した
+    std::atomic<bool> analysis_finished; // 残りのフレームを解析し終えた
+    bool stopped; // stop() の後始末を済ませた（run() の終わりとデストラクタで2回呼ばれるため）
+    // 取得の方針（run() で設定から写し、実行中は変えない）
+    bool live_source;
+    CapturePolicy capture_policy;
+    std::chrono::steady_clock::duration max_frame_age;
+    DisplayMode display_mode;
+    double preview_fps;
     bool command_mode_active;
-    cv::Mat current_frame;
+    bool latency_test; // 遅延計測モード（コマンドモードを常に有効にし、キーは記録のみ）
+    PreprocessCache preprocess_cache; // 解析スレッド専用
+    PupilTracker pupil_tracker;       // 解析スレッド専用
+    std::unique_ptr<FramePool> frame_pool; // 取得スレッド専用
+    
+    // 設定。実行中の変更は監視スレッドが公開し、解析スレッドがフレームの合間に反映する
+    EyeTrackingConfig config;
+    std::unique_ptr<ConfigWatcher> config_watcher;
+    uint64_t applied_config_generation; // 解析スレッド専用
+    
+    // ユーザーごとのキャリブレーション。新しく較正した結果は stop() で保存する
+    CalibrationStore calibration_store;
+    std::string calibration_user;
+    CalibrationRecord calibration_record; // 解析スレッド専用
+    bool calibration_dirty;                // 解析スレッド専用
+    bool profile_loaded;                   // 解析スレッド専用。設定の再読み込み後もプロファイルの値を使う
+    std::mutex user_switch_mutex;
+    std::string pending_user;
+    std::atomic<bool> user_switch_pending;
     
+    // 多点キャリブレーション（要求は他スレッドから、進行は解析スレッド）
+    static const int MAPPING_ROWS_PER_FRAME = 8; // 参照表の作り直しを1フレームで進める行数
+    GazeCalibrationSession calibration_session; // 解析スレッド専用
+    std::atomic<int> calibration_request;        // 0: なし、5 または 9: 点の数
+    std::atomic<int> refinement_request;         // -1: なし、それ以外: 測り直す点の番号
+    
+    // 取得 -> 解析 -> 表示 のステージ間キュー
+    SPSCQueue<FramePacketPtr> capture_queue;
+    SPSCQueue<FramePacketPtr> present_queue;
+    // LatestOnly での取得 -> 解析の受け渡し（std::atomic_exchange で最新の1つだけを置く）
+    FramePacketPtr latest_frame;
+    std::thread capture_thread;
+    std::thread analysis_thread;
+    
+    // 処理段ごとの処理時間と、フレーム数・破棄数・検出の失敗の件数
+    PipelineMetrics metrics;
+    std::string metrics_path; // 空なら書き出さない
+
 public:
     EyeTracker();
     ~EyeTracker();
     
+    // 設定を各コンポーネントに反映する（run() の前に呼ぶ。カメラ設定は initialize で使う）
+    void applyConfig(const EyeTrackingConfig& new_config);
+    // 設定ファイルを監視し、変更を実行中のパイプラインに反映する
+    void watchConfig(const std::string& config_path);
+    const EyeTrackingConfig& getConfig() const { return config; }
+    
+    // キャリブレーションの保存先を開き、user のプロファイルがあれば較正済みの状態で始める
+    bool openCalibrationStore(const std::string& store_path, const std::string& user);
+    // 使うプロファイルを切り替える（実行中はフレームの合間に反映する）
+    void switchUser(const std::string& user);
+    
+    // 5点・9点キャリブレーションを始める（プレビューに出る目標を順に見る。'c' キーでも開始）
+    void startGazeCalibration(int point_count);
+    // キャリブレーションの1点だけを測り直す（写像の参照表は数フレームかけて作り直す）
+    void refineGazeCalibrationPoint(size_t index);
+    
     bool initialize(int camera_id = 0);
+    // 録画ファイルまたは連番画像ディレクトリから再生する
+    bool initialize(const std::string& replay_path,
+                    ReplayPacing pacing = ReplayPacing::Realtime);
+    // 任意の入力（合成画像など）を使う
+    bool initialize(std::unique_ptr<FrameSource> frame_source);
+    // 視線でカーソルを連続的に動かす（run() の前に呼ぶ。backend が nullptr なら実際のカーソル）
+    bool enablePointerMode(std::unique_ptr<CursorBackend> backend = nullptr);
+    GazeCursor* getGazeCursor() { return gaze_cursor.get(); }
+    // 撮影からキー入力までの遅延を測る（run() の前に呼ぶ）
+    // コマンドモードを常に有効にし、キーは実際には送らずに送信スレッドが押した時刻だけ記録する
+    // 再生入力と組み合わせると、カメラを除いたパイプライン部分の遅延が分かる
+    bool enableLatencyTest();
+    // 表示方法を選ぶ（run() の前に呼ぶ。preview_fps は Preview のときの描画の上限）
+    void setDisplayMode(DisplayMode mode, double preview_fps = 10.0);
     void run();
     void stop();
+    // 実行中のループに終了を求める（シグナルハンドラから呼んでよい。後始末は run() が行う）
+    void requestStop() { is_running = false; }
     
+    PipelineOccupancy getPipelineOccupancy() const;
+    PipelineMetrics& getMetrics() { return metrics; }
+    const PipelineMetrics& getMetrics() const { return metrics; }
+    // 計測値の書き出し先（拡張子 .csv なら CSV、それ以外は Prometheus のテキスト形式）
+    // 終了時と、実行中の 'm' キーで書き出す
+    void setMetricsOutput(const std::string& path);
+    bool writeMetrics();
+
 private:
-    void processFrame();
-    void handleDoubleBlinkDetected();
-    void handleGazeDirection(cv::Point2f direction);
+    void captureLoop();
+    void analysisLoop();
+    void presentationLoop();
+    void headlessLoop();
+    // 取得の方針に従って解析する次のフレームを取る（解析スレッド）
+    bool takeFrame(FramePacketPtr& packet);
+    
+    // key_backend が nullptr ならプラットフォームの既定バックエンドを使う
+    void createCommandController(std::unique_ptr<KeyBackend> key_backend);
+    void applyPendingConfig();
+    bool applyCalibrationProfile(const std::string& user);
+    void recordCalibration(PreprocessCache& cache, const FrameAnalysis& analysis);
+    void saveCalibration();
+    void updateGazeCalibration(const FrameAnalysis& analysis, const cv::Size& roi_size);
+    void processFrame(FramePacket& packet);
+    void presentFrame(FramePacket& packet);
+    void handleDoubleBlinkDetected(const FrameAnalysis& analysis);
+    void handleGazeDirection(const FrameAnalysis& analysis);
 };
 
 #endif
@@ -0,0 +1,42 @@
+#ifndef FRAMEANALYSIS_H
+#define FRAMEANALYSIS_H
+
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include "BlinkGesture.h"
+
+// 瞳孔追跡の状態
+enum class PupilTrackState {
+    Lost,       // 追跡していない（全体検出でも見つからなかった）
+    Predicted,  // 予測位置の付近で瞳孔を確認できなかった（目を閉じている可能性）
+    Confirmed   // 予測位置の付近で確認した、または全体検出で見つけた
+};
+
+// 1フレーム分の解析結果
+// 瞳孔検出・EAR計算はフレームごとに1回だけ行い、各コンポーネントで共有する
+struct FrameAnalysis {
+    // フレームの取得時刻（再生時は記録上の時刻）
+    std::chrono::steady_clock::time_point timestamp;
+    // フレームが撮られた実時刻（ドライバの時刻があればそれ）。視線からキー入力までの遅延の起点
+    std::chrono::steady_clock::time_point capture_time;
+    
+    cv::Point2f pupil_center = cv::Point2f(-1, -1);
+    bool pupil_found = false;
+    PupilTrackState pupil_track_state = PupilTrackState::Lost;
+    // Confirmed のうち、予測位置の付近の小窓で瞳孔を確認したもの（全体検出で見つけたものは含まない）
+    bool pupil_window_confirmed = false;
+    cv::Point2f gaze_direction = cv::Point2f(0, 0);
+    
+    double ear = 1.0; // 目の開き具合（BlinkDetector で選択した方法の値）
+    bool blink_detected = false;
+    bool double_blink = false;
+    BlinkGesture gesture = BlinkGesture::None;
+    
+    bool command_active = false;
+    
+    // 多点キャリブレーション中は注視してほしい目標（画面中央が (0,0)、端が ±1）
+    bool calibrating = false;
+    cv::Point2f calibration_target = cv::Point2f(0, 0);
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef FRAMEPACKET_H
+#define FRAMEPACKET_H
+
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include "FrameAnalysis.h"
+
+// パイプラインの各ステージ間で受け渡す1フレーム分のデータ
+// shared_ptr で参照カウントされ、画像バッファはコピーされない
+struct FramePacket {
+    cv::Mat frame;
+    uint64_t sequence = 0;
+    std::chrono::steady_clock::time_point capture_time;
+
+    // 解析ステージの結果（表示ステージで使用）
+    FrameAnalysis analysis;
+};
+
+using FramePacketPtr = std::shared_ptr<FramePacket>;
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include "FramePacket.h"
+
+// 取得ステージで使い回す FramePacket の固定プール
+// プールだけが参照を持つパケット（他ステージが手放したもの）を再利用する
+// acquire() は取得スレッドからのみ呼ぶこと
+class FramePool {
+private:
+    std::vector<FramePacketPtr> packets;
+    size_t next_index;
+
+public:
+    FramePool(size_t packet_count, const cv::Size& frame_size, int frame_type = CV_8UC3);
+    
+    // 空きがなければ nullptr を返す
+    FramePacketPtr acquire();
+    size_t size() const { return packets.size(); }
+    size_t available() const;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef FRAMESOURCE_H
+#define FRAMESOURCE_H
+
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <string>
+
+// 解析が取得に追いつかないときの、ライブ入力のフレームの扱い
+// 記録済みの入力は常に後段が空くまで待つ（破棄しない）
+enum class CapturePolicy {
+    LatestOnly,   // 最新の1フレームだけを解析に渡し、未解析の古いフレームは置き換える
+    BoundedQueue, // 固定長のキューに積み、満杯なら新しいフレームを捨てる
+    Deadline      // キューに積み、撮影から MaxFrameAge を過ぎたフレームは解析せずに捨てる
+};
+
+// EyeTracker にフレームを供給する入力の共通インターフェース
+// タイムスタンプは瞬き・タイムアウト判定にそのまま使われる
+class FrameSource {
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    virtual ~FrameSource() = default;
+    
+    virtual bool isOpened() const = 0;
+    virtual void release() = 0;
+    
+    // 次のフレームを読み込む。終端または失敗時は false
+    virtual bool read(cv::Mat& frame, Clock::time_point& timestamp) = 0;
+    // 画像を展開せずに1フレーム読み捨てる
+    virtual bool skip() = 0;
+    
+    virtual cv::Size frameSize() const = 0;
+    virtual double fps() const = 0;
+    
+    // ライブ入力は取りこぼしを許容し、記録済み入力は後段が空くまで待つ
+    virtual bool isLive() const = 0;
+    // read() が次のフレームの時刻まで待つか（ライブ入力と、記録時のレートで再生する入力）
+    virtual bool isPaced() const { return isLive(); }
+    
+    // 直前に読んだフレームが撮られた実時刻（遅延の計測の起点）
+    // read() のタイムスタンプは再生時に記録上の時刻になるため、別に持つ
+    Clock::time_point lastCaptureTime() const { return last_capture_time; }
+
+protected:
+    Clock::time_point last_capture_time;
+};
+
+// ローカルカメラ
+class CameraSource : public FrameSource {
+private:
+    cv::VideoCapture cap;
+    bool driver_timestamps = false; // 直前のフレームでドライバの時刻を使えたか
+
+public:
+    bool open(int camera_id, int width = 640, int height = 480, double fps = 30);
+    
+    bool isOpened() const override { return cap.isOpened(); }
+    void release() override;
+    bool read(cv::Mat& frame, Clock::time_point& timestamp) override;
+    bool skip() override;
+    cv::Size frameSize() const override;
+    double fps() const override;
+    bool isLive() const override { return true; }
+    
+    bool usesDriverTimestamps() const { return driver_timestamps; }
+
+private:
+    Clock::time_point driverTimestamp(Clock::time_point grabbed);
+};
+
+#endif
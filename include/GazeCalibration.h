@@ -0,0 +1,52 @@
+#ifndef GAZECALIBRATION_H
+#define GAZECALIBRATION_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include "GazeMapping.h"
+
+// 5点・9点キャリブレーションの進行
+// 目標を1つずつ示し、視線が落ち着くまでの数フレームを捨ててから瞳孔位置を集め、中央値を取る
+class GazeCalibrationSession {
+private:
+    static const int SETTLE_FRAMES = 15;  // 目標が変わってから視線が移るまで（30 fps で約 0.5 秒）
+    static const int SAMPLE_FRAMES = 20;  // 1点あたりに集めるフレーム数
+    static constexpr float TARGET_EXTENT = 0.8f; // 目標を置く範囲（画面端を ±1 として）
+    
+    std::vector<cv::Point2f> targets;
+    std::vector<GazeMapping::CalibrationPoint> results;
+    std::vector<float> samples_x;
+    std::vector<float> samples_y;
+    size_t current;
+    int frames_on_target;
+    bool active;
+    bool refinement;        // 1点だけの測り直し
+    size_t refined_index;   // 測り直す点の番号
+
+public:
+    GazeCalibrationSession();
+    
+    // point_count は 5（中央と四隅）か 9（3×3 の格子）
+    static std::vector<cv::Point2f> pattern(int point_count);
+    
+    void begin(int point_count);
+    // 既存のキャリブレーションの1点だけを測り直す
+    void beginRefinement(size_t index, cv::Point2f target);
+    void cancel();
+    
+    // 1フレーム分の瞳孔位置を渡す（見つからなかったフレームは数えない）。全ての点を取り終えたら true
+    bool addSample(cv::Point2f pupil, bool pupil_found);
+    
+    bool isActive() const { return active; }
+    bool isRefinement() const { return refinement; }
+    cv::Point2f currentTarget() const { return targets[current]; }
+    size_t currentIndex() const { return current; }
+    size_t targetCount() const { return targets.size(); }
+    size_t refinedIndex() const { return refined_index; }
+    const std::vector<GazeMapping::CalibrationPoint>& points() const { return results; }
+
+private:
+    void restart(std::vector<cv::Point2f> new_targets);
+};
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef GAZECURSOR_H
+#define GAZECURSOR_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// カーソルの移動先
+class CursorBackend {
+public:
+    virtual ~CursorBackend() = default;
+    
+    virtual cv::Size screenSize() const = 0;
+    virtual void move(int x, int y) = 0;
+    virtual const char* name() const = 0;
+};
+
+// PlatformController::moveMouse で実際のカーソルを動かす
+class PlatformCursorBackend : public CursorBackend {
+private:
+    cv::Size screen;
+
+public:
+    PlatformCursorBackend();
+    
+    cv::Size screenSize() const override { return screen; }
+    void move(int x, int y) override;
+    const char* name() const override { return "platform"; }
+    // 画面サイズが取れなければ使えない
+    bool isAvailable() const { return screen.area() > 0; }
+};
+
+// 移動先を記録するだけのバックエンド（テスト・ヘッドレス用）
+struct RecordedCursorMove {
+    cv::Point position;
+    std::chrono::steady_clock::time_point time;
+};
+
+class RecordingCursorBackend : public CursorBackend {
+private:
+    cv::Size screen;
+    mutable std::mutex moves_mutex;
+    std::vector<RecordedCursorMove> recorded;
+
+public:
+    explicit RecordingCursorBackend(cv::Size screen_size = cv::Size(1920, 1080));
+    
+    cv::Size screenSize() const override { return screen; }
+    void move(int x, int y) override;
+    const char* name() const override { return "recording"; }
+    
+    std::vector<RecordedCursorMove> moves() const;
+};
+
+// 視線ベクトルを画面座標に写し、カメラより高いレートでカーソルを滑らかに動かす
+// update() は解析スレッドからカメラのレートで呼ぶ。カーソル出力は専用のタイマースレッドが
+// 直近2サンプルの間を補間し、指数平滑をかけてから output_hz で送る。
+class GazeCursor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    struct Sample {
+        cv::Point2f target;
+        Clock::time_point received;
+    };
+    
+    std::unique_ptr<CursorBackend> backend;
+    const Clock::duration output_period;
+    const double gain;            // 視線ベクトル 1.0 が画面の半幅の何倍か
+    const double smoothing_ms;    // 指数平滑の時定数
+    
+    // update() と出力スレッドの共有部分
+    std::mutex sample_mutex;
+    Sample previous_sample;
+    Sample latest_sample;
+    double sample_interval_ms;    // サンプル間隔の移動平均
+    int sample_count;
+    
+    // 出力スレッド専用
+    cv::Point2f smoothed;
+    cv::Point last_sent;
+    
+    std::thread worker;
+    std::atomic<bool> running;
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    
+    std::atomic<uint64_t> update_count;
+    std::atomic<uint64_t> tick_count;
+    std::atomic<uint64_t> move_count;
+
+public:
+    explicit GazeCursor(std::unique_ptr<CursorBackend> backend, double output_hz = 120.0,
+                        double gain = 1.5, double smoothing_ms = 40.0);
+    ~GazeCursor();
+    
+    GazeCursor(const GazeCursor&) = delete;
+    GazeCursor& operator=(const GazeCursor&) = delete;
+    
+    bool start();
+    void stop();
+    
+    // 新しい視線位置（GazeEstimator::calculateGazePosition の値。デッドゾーンをかけないもの）を渡す
+    void update(cv::Point2f gaze_position);
+    // 視線ベクトルを画面座標に変換する（画面外は端に丸める）
+    cv::Point2f mapToScreen(cv::Point2f gaze_direction) const;
+    
+    const char* backendName() const { return backend->name(); }
+    CursorBackend* getBackend() { return backend.get(); }
+    uint64_t updateCount() const { return update_count.load(std::memory_order_relaxed); }
+    uint64_t tickCount() const { return tick_count.load(std::memory_order_relaxed); }
+    uint64_t moveCount() const { return move_count.load(std::memory_order_relaxed); }
+
+private:
+    void outputLoop();
+    void tick(Clock::time_point now, double elapsed_ms);
+};
+
+#endif
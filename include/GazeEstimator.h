@@ -2,8 +2,31 @@
 #define GAZEESTIMATOR_H
 
 #include <opencv2/opencv.hpp>
+#include <array>
+#include "PreprocessCache.h"
+#include "GazeMapping.h"
+#include "GradientPupilLocator.h"
+#include "Metrics.h"
+
+struct GazeConfig;
+
+// 瞳孔中心の検出方法（どちらも見つからなければ輪郭法にフォールバックする）
+enum class PupilLocatorMethod {
+    HoughCircles,
+    Gradient
+};
+
+// ピラミッド探索の段ごとの処理時間（直前の1回分）
+// level_ms[0] は原寸の小窓での絞り込み、level_ms[k] は 1/2^k の画像の作成と探索
+struct PyramidTiming {
+    int levels = 0;
+    std::array<double, MatArena::MAX_PYRAMID_LEVELS + 1> level_ms = {};
+};
 
 class GazeEstimator {
+    // 内部処理を単体で計測するため
+    friend class EyeTrackerBench;
+
 private:
     cv::Point2f baseline_pupil_pos;
     cv::Size eye_roi_size;
@@ -12,18 +35,55 @@ private:
     double movement_threshold;
     double deadzone_radius;
     
+    PupilLocatorMethod locator_method;
+    GradientPupilLocator gradient_locator;
+    
+    int pyramid_levels;
+    PyramidTiming pyramid_timing;
+    
+    // 多点キャリブレーションの写像（未推定なら基準点からの差分を使う）
+    GazeMapping gaze_mapping;
+    
+    PipelineMetrics* metrics; // nullptr なら計測しない
+
 public:
     GazeEstimator(double threshold = 0.05, double deadzone = 0.1);
     
+    // 閾値と瞳孔検出の方法を設定から反映する（基準位置はそのまま）
+    void configure(const GazeConfig& config);
+    
     cv::Point2f detectPupilCenter(const cv::Mat& eye_roi);
+    cv::Point2f detectPupilCenter(PreprocessCache& cache);
     cv::Point2f calculateGazeDirection(const cv::Mat& eye_roi);
+    cv::Point2f calculateGazeDirection(const cv::Point2f& pupil_center) const;
+    // デッドゾーンと移動閾値をかけない視線位置（画面中央が (0,0)。ポインタモード用）
+    cv::Point2f calculateGazePosition(const cv::Point2f& pupil_center) const;
     void calibrateBaseline(const cv::Mat& eye_roi);
-    bool isCalibrated() const { return is_calibrated; }
+    void calibrateBaseline(const cv::Point2f& pupil_center, const cv::Size& roi_size);
+    bool isCalibrated() const { return is_calibrated || gaze_mapping.isReady(); }
+    bool hasBaseline() const { return is_calibrated; }
+    const cv::Point2f& getBaseline() const { return baseline_pupil_pos; }
+    const cv::Size& getCalibratedRoiSize() const { return eye_roi_size; }
+    GazeMapping& mapping() { return gaze_mapping; }
+    const GazeMapping& mapping() const { return gaze_mapping; }
     
+    void setPupilLocator(PupilLocatorMethod method) { locator_method = method; }
+    PupilLocatorMethod getPupilLocator() const { return locator_method; }
+    
+    // ハフ変換を縮小画像で粗く行い、原寸の小窓で中心を詰める（0 で無効、1 で 1/2、2 で 1/4）
+    void setPyramidLevels(int levels);
+    int getPyramidLevels() const { return pyramid_levels; }
+    const PyramidTiming& lastPyramidTiming() const { return pyramid_timing; }
+    
+    // 前処理・ハフ変換・輪郭法の処理時間と検出の失敗を記録する
+    void setMetrics(PipelineMetrics* target) { metrics = target; }
+
 private:
-    cv::Point2f findPupilUsingHoughCircles(const cv::Mat& eye_roi);
-    cv::Point2f findPupilUsingContours(const cv::Mat& eye_roi);
-    cv::Mat preprocessEyeImage(const cv::Mat& eye_roi);
+    cv::Point2f findPupilUsingHoughCircles(PreprocessCache& cache);
+    cv::Point2f findPupilUsingPyramid(PreprocessCache& cache);
+    cv::Point2f findPupilUsingGradient(PreprocessCache& cache);
+    cv::Point2f findPupilUsingContours(PreprocessCache& cache);
+    const cv::Mat& preprocessEyeImage(PreprocessCache& cache);
 };
 
 #endif
@@ -0,0 +1,78 @@
+#ifndef GAZEMAPPING_H
+#define GAZEMAPPING_H
+
+#include <opencv2/opencv.hpp>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// 瞳孔位置（目領域の画素座標）→ 視線（画面上の正規化座標。中央が (0,0)、端が ±1）の写像
+// キャリブレーション点に多項式を当てはめ、その値を目領域全体の格子に焼き込んでおく。
+// 毎フレームの変換は格子の双線形補間1回だけで、多項式は評価しない。
+class GazeMapping {
+public:
+    // 2次まで: 1, x, y, xy, x^2, y^2（点の数に応じて項を減らす）
+    static const int MAX_TERMS = 6;
+    // 参照表の長い辺の分割数
+    static const int GRID_CELLS = 64;
+    
+    struct CalibrationPoint {
+        cv::Point2f pupil;   // 注視中の瞳孔位置（画素）
+        cv::Point2f target;  // 注視した目標（正規化座標）
+    };
+
+private:
+    struct Table {
+        int cols = 0;
+        int rows = 0;
+        float cell_size = 1.0f;           // 1セルの画素数
+        std::vector<cv::Point2f> nodes;   // (cols + 1) × (rows + 1) の格子点の値
+        bool ready = false;
+    };
+    
+    cv::Size roi_size;
+    std::vector<CalibrationPoint> points;
+    int terms;
+    std::array<double, MAX_TERMS> coeff_x;
+    std::array<double, MAX_TERMS> coeff_y;
+    
+    // active を参照しながら pending を少しずつ作り、できあがったら入れ替える
+    Table active;
+    Table pending;
+    int pending_row;
+
+public:
+    GazeMapping();
+    
+    // 点を当てはめて参照表を作り直す（点が3つ未満、または退化していれば false）
+    bool fit(const std::vector<CalibrationPoint>& calibration_points, cv::Size eye_roi_size);
+    // 1点だけ測り直す。係数を当て直し、参照表は advanceRebuild() で少しずつ作り直す
+    bool refinePoint(size_t index, cv::Point2f pupil);
+    // 作り直し中の参照表を最大 max_rows 行だけ進める（毎フレーム呼ぶ）
+    void advanceRebuild(int max_rows);
+    
+    // 保存済みの係数から復元する（参照表はここで一度に作る）
+    bool setModel(cv::Size eye_roi_size, int term_count, const float* x_coefficients, const float* y_coefficients);
+    
+    bool isReady() const { return active.ready; }
+    bool isRebuilding() const { return pending_row >= 0; }
+    
+    // 参照表の双線形補間（毎フレームの変換）
+    cv::Point2f lookup(cv::Point2f pupil) const;
+    // 多項式を直接評価する（参照表の検証用）
+    cv::Point2f evaluate(cv::Point2f pupil) const;
+    
+    int termCount() const { return terms; }
+    double coefficientX(int term) const { return coeff_x[term]; }
+    double coefficientY(int term) const { return coeff_y[term]; }
+    cv::Size roiSize() const { return roi_size; }
+    const std::vector<CalibrationPoint>& calibrationPoints() const { return points; }
+
+private:
+    bool solve();
+    void basis(double x, double y, double* out) const;
+    void startRebuild();
+    void buildRows(Table& table, int first_row, int last_row) const;
+};
+
+#endif
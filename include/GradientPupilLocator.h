@@ -0,0 +1,62 @@
+#ifndef GRADIENTPUPILLOCATOR_H
+#define GRADIENTPUPILLOCATOR_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// 勾配ベクトルの集中度（means of gradients）による瞳孔中心の推定
+// 瞳孔の縁の勾配は中心から外向きに揃うため、各候補点 c について
+//   暗さ(c) * Σ max(0, d_i · g_i)^2   （d_i: c から勾配点への単位ベクトル）
+// が最大になる点を瞳孔中心とする。
+// 縮小画像で全候補を評価したあと、原寸で山登りし、二次補間でサブピクセル位置を求める。
+// 内積の総和は AVX2 / SSE2 / スカラーを実行時に切り替えて計算する。
+class GradientPupilLocator {
+public:
+    enum class Kernel {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+private:
+    // 勾配点（構造体の配列ではなく配列の構造体にしてベクトル化しやすくする）
+    struct GradientField {
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> gx;
+        std::vector<float> gy;
+        
+        void clear();
+        size_t size() const { return x.size(); }
+    };
+    
+    int coarse_width;
+    size_t max_refine_points;
+    Kernel kernel;
+    
+    cv::Mat coarse_image;
+    std::vector<float> magnitude_buffer;
+    GradientField coarse_field;
+    GradientField fine_field;
+
+public:
+    explicit GradientPupilLocator(int coarse_width = 48, size_t max_refine_points = 4096);
+    
+    // gray: ノイズ除去済みのグレースケール画像。見つからなければ (-1, -1)
+    cv::Point2f locate(const cv::Mat& gray);
+    
+    Kernel activeKernel() const { return kernel; }
+    static const char* kernelName(Kernel kernel);
+    // 実行中のCPUで使える最速のカーネル
+    static Kernel detectKernel();
+    // 計測・比較用にカーネルを固定する（CPUが対応していない指定は無視）
+    void forceKernel(Kernel forced);
+
+private:
+    void collectGradients(const cv::Mat& image, const cv::Rect& region, int stride,
+                          GradientField& field);
+    double objective(const GradientField& field, float cx, float cy) const;
+    double weightedObjective(const GradientField& field, const cv::Mat& image, int x, int y) const;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef KEYBACKEND_H
+#define KEYBACKEND_H
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// 送信するキー（各バックエンドがプラットフォームのキーコードに変換する）
+enum class InjectedKey {
+    Up,
+    Down,
+    Left,
+    Right
+};
+
+// キー入力の送信先
+// open() で接続を1回だけ開き、close() まで保持する（開いていれば open() は何もせず true）。
+// press/release は KeyInjector のスレッドからのみ呼ばれる
+class KeyBackend {
+public:
+    virtual ~KeyBackend() = default;
+    
+    virtual bool open() = 0;
+    virtual void close() = 0;
+    virtual void press(InjectedKey key) = 0;
+    virtual void release(InjectedKey key) = 0;
+    virtual const char* name() const = 0;
+};
+
+// 送信したキーを記録するだけのバックエンド（テスト・ヘッドレス用）
+struct RecordedKeyEvent {
+    InjectedKey key;
+    bool pressed;
+    std::chrono::steady_clock::time_point time;
+};
+
+class RecordingKeyBackend : public KeyBackend {
+private:
+    mutable std::mutex events_mutex;
+    std::vector<RecordedKeyEvent> recorded;
+    bool opened = false;
+
+public:
+    bool open() override;
+    void close() override;
+    void press(InjectedKey key) override;
+    void release(InjectedKey key) override;
+    const char* name() const override { return "recording"; }
+    
+    // 記録したイベントのコピー（他スレッドから呼んでよい）
+    std::vector<RecordedKeyEvent> events() const;
+    bool isOpened() const { return opened; }
+};
+
+// 各プラットフォームのバックエンド（使えない環境では nullptr）
+std::unique_ptr<KeyBackend> createXTestKeyBackend();
+std::unique_ptr<KeyBackend> createUinputKeyBackend();
+std::unique_ptr<KeyBackend> createWindowsKeyBackend();
+
+// 使えるものを順に試して、開いたままのバックエンドを返す
+// Windows: SendInput、Linux: XTest → uinput、どれも開けなければ記録のみ
+std::unique_ptr<KeyBackend> createDefaultKeyBackend();
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef KEYINJECTOR_H
+#define KEYINJECTOR_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "KeyBackend.h"
+#include "Metrics.h"
+#include "SPSCQueue.h"
+
+// キー入力を専用スレッドから送る
+// 解析スレッドは send() でロックフリーキューに積むだけで、押下・解放の待ち時間を負わない。
+// 解放は sleep ではなく、押下時刻 + hold_time を期限とするタイマーで行う。
+// 押下中のキーがまた送られたら、解放してから押し直す（視線を保つ間は hold_time ごとに繰り返し押される）。
+class KeyInjector {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    struct KeyCommand {
+        InjectedKey key = InjectedKey::Up;
+        Clock::time_point requested; // 遅延の起点（コマンドの元になったフレームの撮影時刻）
+        Clock::time_point queued;
+    };
+    
+    // 押下中のキーと解放予定時刻
+    struct PendingRelease {
+        InjectedKey key = InjectedKey::Up;
+        Clock::time_point release_at;
+        bool active = false;
+        // 押下中に同じキーが来たら、解放した直後に押し直す（その間に来た分は1回にまとめる）
+        bool repress = false;
+        KeyCommand repress_command;
+    };
+    
+    static const size_t QUEUE_CAPACITY = 32;
+    static const size_t MAX_HELD_KEYS = 4; // InjectedKey の種類数
+    
+    std::unique_ptr<KeyBackend> backend;
+    std::chrono::milliseconds hold_time;
+    SPSCQueue<KeyCommand> queue;
+    std::array<PendingRelease, MAX_HELD_KEYS> pending;
+    
+    std::thread worker;
+    std::atomic<bool> running;
+    // 起床通知用（キュー自体はロックフリー。ワーカーの待機にだけ使う）
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    
+    std::atomic<uint64_t> sent_count;     // バックエンドで実際に押したキー
+    std::atomic<uint64_t> dropped_count;  // キューが満杯で捨てたもの
+    std::atomic<uint64_t> merged_count;   // 押し直し待ちにまとめたもの
+    // キーを押した時点で、キューでの待ちと起点からの遅延を記録する
+    std::atomic<PipelineMetrics*> metrics;
+
+public:
+    explicit KeyInjector(std::unique_ptr<KeyBackend> backend,
+                         std::chrono::milliseconds hold_time = std::chrono::milliseconds(50));
+    ~KeyInjector();
+    
+    KeyInjector(const KeyInjector&) = delete;
+    KeyInjector& operator=(const KeyInjector&) = delete;
+    
+    // バックエンドを開いて送信スレッドを起動する
+    bool start();
+    // 押下中のキーを解放してからスレッドを止める
+    void stop();
+    
+    // 押下して hold_time 後に解放する。キューが満杯なら捨てて false（呼び出し側は待たない）
+    // requested は遅延の起点（既定値の time_point なら起点からの遅延は記録しない）
+    bool send(InjectedKey key, Clock::time_point requested = Clock::now());
+    
+    void setMetrics(PipelineMetrics* target) { metrics.store(target, std::memory_order_release); }
+    
+    const char* backendName() const { return backend ? backend->name() : "none"; }
+    KeyBackend* getBackend() { return backend.get(); }
+    uint64_t sentCount() const { return sent_count.load(std::memory_order_relaxed); }
+    uint64_t droppedCount() const { return dropped_count.load(std::memory_order_relaxed); }
+    uint64_t mergedCount() const { return merged_count.load(std::memory_order_relaxed); }
+
+private:
+    void workerLoop();
+    void pressKey(const KeyCommand& command, Clock::time_point now);
+    void emitPress(const KeyCommand& command);
+    void releaseDue(Clock::time_point now, bool release_all);
+    Clock::time_point nextDeadline(Clock::time_point idle_deadline) const;
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef MATARENA_H
+#define MATARENA_H
+
+#include <opencv2/opencv.hpp>
+#include <array>
+#include <vector>
+
+// パイプラインごとに保持する作業バッファ群
+// 毎フレーム同じサイズで再利用し、定常状態でヒープ確保が起きないようにする
+class MatArena {
+public:
+    enum MatSlot {
+        MAT_GRAY,
+        MAT_BLURRED,
+        MAT_ADAPTIVE,
+        MAT_OTSU,
+        MAT_INVERTED,
+        MAT_REFINE_BLURRED,  // ピラミッド探索の原寸小窓（先頭から小窓サイズ分だけ使う）
+        MAT_REFINE_BINARY,
+        MAT_SLOT_COUNT
+    };
+    
+    enum ContourSlot {
+        CONTOURS_EYE,
+        CONTOURS_PUPIL,
+        CONTOUR_SLOT_COUNT
+    };
+    
+    // 縮小画像の段数の上限（1段ごとに 1/2）
+    static const int MAX_PYRAMID_LEVELS = 3;
+    
+    using Contour = std::vector<cv::Point>;
+    using Contours = std::vector<Contour>;
+
+private:
+    static const size_t RESERVED_CONTOURS = 64;
+    
+    std::array<cv::Mat, MAT_SLOT_COUNT> mats;
+    std::array<cv::Mat, MAX_PYRAMID_LEVELS> pyramid_levels;
+    cv::Mat pyramid_binary;
+    std::array<Contours, CONTOUR_SLOT_COUNT> contour_sets;
+    std::vector<cv::Vec3f> circle_buffer;
+    cv::Size reserved_size;
+
+public:
+    MatArena();
+    
+    // ROIサイズが変わったときだけ全バッファを確保し直す
+    void reserve(const cv::Size& roi_size);
+    const cv::Size& reservedSize() const { return reserved_size; }
+    
+    cv::Mat& mat(MatSlot slot) { return mats[slot]; }
+    Contours& contours(ContourSlot slot) { return contour_sets[slot]; }
+    std::vector<cv::Vec3f>& circles() { return circle_buffer; }
+    
+    // level: 1 で 1/2、2 で 1/4 ...（cv::pyrDown と同じサイズ）
+    cv::Mat& pyramid(int level) { return pyramid_levels[level - 1]; }
+    // 縮小画像の二値化用（1/2 のサイズで確保し、先頭から使う）
+    cv::Mat& pyramidBinary() { return pyramid_binary; }
+};
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// 処理時間のヒストグラム（HDR 形式: 2 の冪ごとに 16 分割、相対誤差は約 6%）
+// record は複数スレッドから同時に呼んでよい（relaxed な fetch_add のみでロックしない）
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_EXPONENT = 42;  // 2^42 ns（約 73 分）以上は最後のバケットに入れる
+    static const int BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+    
+    // ある時点の値のコピー（集計・出力用）
+    struct Snapshot {
+        uint64_t count = 0;
+        uint64_t sum_ns = 0;
+        uint64_t max_ns = 0;
+        std::vector<uint64_t> buckets;
+        
+        double meanNs() const { return count ? static_cast<double>(sum_ns) / count : 0.0; }
+        // quantile は 0〜1。バケットの中央値を返す
+        double percentileNs(double quantile) const;
+    };
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets;
+    std::atomic<uint64_t> sum_ns;
+    std::atomic<uint64_t> max_ns;
+
+public:
+    LatencyHistogram();
+    
+    void record(uint64_t nanoseconds);
+    Snapshot snapshot() const;
+    void reset();
+    
+    static int bucketIndex(uint64_t nanoseconds);
+    static uint64_t bucketLowerBound(int index);
+    static uint64_t bucketUpperBound(int index);
+};
+
+// 計測する処理段
+enum class MetricStage {
+    CaptureWait,      // フレームが届くまでの待ち
+    Preprocess,       // グレースケール化・ブラー・二値化
+    PupilTrack,       // 瞳孔の追跡（予測位置の付近の確認）
+    Hough,            // ハフ変換による瞳孔検出
+    ContourFallback,  // 輪郭法へのフォールバック
+    Ear,              // 目の開き具合
+    Gaze,             // 視線方向の算出
+    CommandDispatch,  // 方向コマンドの送出
+    Render,           // デバッグ表示の描画と表示
+    // 撮影からの経過時間（処理時間ではなく、フレームの撮影時刻を起点とする）
+    CaptureToAnalysis, // 撮影から解析の完了まで
+    KeyQueue,          // 方向コマンドを積んでから、送信スレッドがキーを押すまで
+    CaptureToKey,      // 撮影から、送信スレッドがキーを押すまで（視線からキー入力までの遅延）
+    PoolWait,          // 共有プールに解析タスクを積んでから、実行が始まるまで
+    COUNT
+};
+
+// 数える出来事
+enum class MetricCounter {
+    FramesCaptured,
+    FramesAnalyzed,
+    FramesPresented,
+    CaptureDropped,    // 取得時にバッファ・キューが満杯で破棄
+    AnalysisDropped,   // 表示キューが満杯で破棄
+    PreviewSkipped,    // 間引き表示で描画しなかった解析結果
+    StaleFrames,       // 解析を始める時点で撮影から MaxFrameAge を過ぎていたフレーム
+    DeadlineDropped,   // そのうち Deadline の方針で解析せずに捨てたもの
+    PupilLost,         // 瞳孔が見つからなかったフレーム
+    HoughMiss,         // ハフ変換で円が見つからなかった
+    ContourMiss,       // 輪郭法でも見つからなかった
+    CommandsSent,
+    KeysPressed,       // 送信スレッドが実際に押したキー（押し直し待ちにまとめたコマンドは含まない）
+    COUNT
+};
+
+// パイプライン全体の計測値
+// 無効の間は ScopedStageTimer が時刻も読まないので、処理時間の計測の負荷はほぼない
+class PipelineMetrics {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    std::array<LatencyHistogram, static_cast<size_t>(MetricStage::COUNT)> stages;
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(MetricCounter::COUNT)> counters;
+    std::atomic<bool> enabled;
+
+public:
+    PipelineMetrics();
+    
+    void setEnabled(bool value) { enabled.store(value, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+    
+    void record(MetricStage stage, Clock::duration elapsed);
+    // 件数は無効の間も数える（パイプラインの滞留状況の表示にも使うため）
+    void increment(MetricCounter counter, uint64_t amount = 1) {
+        counters[static_cast<size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+    }
+    
+    LatencyHistogram::Snapshot stageSnapshot(MetricStage stage) const;
+    uint64_t counterValue(MetricCounter counter) const;
+    void reset();
+    
+    // Prometheus のテキスト形式（node_exporter の textfile collector でそのまま読める）
+    void writePrometheus(std::ostream& out) const;
+    void writeCsv(std::ostream& out) const;
+    // 拡張子が .csv なら CSV、それ以外は Prometheus 形式。一時ファイルに書いてから置き換える
+    bool writeFile(const std::string& path) const;
+    
+    static const char* stageName(MetricStage stage);
+    static const char* counterName(MetricCounter counter);
+};
+
+// スコープの処理時間を記録する（metrics が nullptr または無効なら何もしない）
+class ScopedStageTimer {
+private:
+    PipelineMetrics* metrics;
+    MetricStage stage;
+    PipelineMetrics::Clock::time_point start;
+
+public:
+    ScopedStageTimer(PipelineMetrics* target, MetricStage timed_stage)
+        : metrics(target && target->isEnabled() ? target : nullptr), stage(timed_stage) {
+        if (metrics) {
+            start = PipelineMetrics::Clock::now();
+        }
+    }
+    
+    ~ScopedStageTimer() {
+        if (metrics) {
+            metrics->record(stage, PipelineMetrics::Clock::now() - start);
+        }
+    }
+    
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+};
+
+#endif
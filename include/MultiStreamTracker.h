@@ -0,0 +1,67 @@
+#ifndef MULTISTREAMTRACKER_H
+#define MULTISTREAMTRACKER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Config.h"
+#include "TrackerSession.h"
+#include "WorkStealingPool.h"
+
+// ストリームごとの結果
+struct StreamReport {
+    std::string name;
+    uint64_t frames = 0;
+    uint64_t dropped = 0;    // 取得時に置き換え・読み捨てたフレーム
+    double seconds = 0.0;
+    double fps = 0.0;
+    double pool_wait_p99_ms = 0.0;  // プールで順番を待った時間
+    double latency_p50_ms = 0.0;    // 撮影から解析の完了まで
+    double latency_p99_ms = 0.0;
+};
+
+struct MultiStreamReport {
+    std::vector<StreamReport> streams;
+    size_t workers = 0;
+    uint64_t stolen_tasks = 0;
+    double seconds = 0.0;
+    double total_fps = 0.0;
+    // Jain の公平性指数（ストリームごとの fps の偏り。1 なら均等、1/N なら1つに集中）
+    double fairness = 0.0;
+};
+
+// 複数のカメラ（席）を1プロセスで扱う
+// セッションごとに状態を持ち、フレームごとの解析はコア数分のワーカーの共有プールで行う
+class MultiStreamTracker {
+private:
+    EyeTrackingConfig config;
+    std::vector<std::unique_ptr<TrackerSession>> sessions;
+    std::unique_ptr<WorkStealingPool> pool;
+    size_t worker_count;
+    std::atomic<bool> stop_requested;
+
+public:
+    // worker_count が 0 ならコア数
+    explicit MultiStreamTracker(size_t worker_count = 0);
+    ~MultiStreamTracker();
+    
+    // 以降に追加するセッションにも使う
+    void applyConfig(const EyeTrackingConfig& new_config);
+    // key_backend が nullptr ならプラットフォームの既定バックエンドを使う
+    void addSession(const std::string& name, std::unique_ptr<FrameSource> source,
+                    std::unique_ptr<KeyBackend> key_backend = nullptr);
+    size_t sessionCount() const { return sessions.size(); }
+    
+    // 全セッションを動かし、全ての入力が終わるか requestStop() まで戻らない
+    bool run();
+    // シグナルハンドラから呼んでよい
+    void requestStop() { stop_requested = true; }
+    
+    MultiStreamReport report() const;
+    static void printReport(const MultiStreamReport& report, std::ostream& out);
+};
+
+#endif
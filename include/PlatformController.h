@@ -5,6 +5,8 @@ class PlatformController {
 public:
     static void sendKeyPress(int key_code);
     static void moveMouse(int x, int y);
+    // 主画面の大きさ。取得できない環境（ディスプレイなし等）では false
+    static bool getScreenSize(int& width, int& height);
 };
 
 #endif
@@ -0,0 +1,43 @@
+#ifndef PREPROCESSCACHE_H
+#define PREPROCESSCACHE_H
+
+#include <opencv2/opencv.hpp>
+#include "MatArena.h"
+
+// 目領域の前処理結果をフレーム単位でキャッシュする
+// 各プレーンは最初に要求されたときに計算され、reset() まで再利用される
+// BlinkDetector と GazeEstimator で同じ変換・フィルタを二重に実行しないためのもの
+// プレーンと検出器の作業バッファは MatArena に置き、フレーム間で使い回す
+class PreprocessCache {
+private:
+    enum Plane {
+        PLANE_GRAY = 1 << 0,
+        PLANE_BLURRED = 1 << 1,
+        PLANE_ADAPTIVE = 1 << 2,
+        PLANE_OTSU = 1 << 3
+    };
+    
+    cv::Mat source_roi;
+    MatArena buffers;
+    unsigned int valid_planes;
+
+public:
+    PreprocessCache();
+    explicit PreprocessCache(const cv::Mat& eye_roi);
+    
+    // 新しいフレームの目領域をセットし、キャッシュを無効化する
+    void reset(const cv::Mat& eye_roi);
+    
+    const cv::Mat& source() const { return source_roi; }
+    cv::Size size() const { return source_roi.size(); }
+    
+    const cv::Mat& gray();
+    const cv::Mat& blurred();        // gray に 5x5 ガウシアンブラー
+    const cv::Mat& adaptiveBinary(); // blurred に適応的閾値処理
+    const cv::Mat& otsuBinary();     // gray に大津の二値化
+    
+    // 検出器が使う作業バッファ
+    MatArena& arena() { return buffers; }
+};
+
+#endif
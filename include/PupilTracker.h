@@ -0,0 +1,65 @@
+#ifndef PUPILTRACKER_H
+#define PUPILTRACKER_H
+
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <cstdint>
+#include "FrameAnalysis.h"
+#include "GazeEstimator.h"
+#include "PreprocessCache.h"
+
+// 検出してから追跡する瞳孔トラッカー
+// 等速モデルのα-βフィルタで次の位置を予測し、予測位置の周辺の小窓で暗い領域を探して確認する。
+// 確認できない状態が一定時間続いたとき（見失い）と一定フレームごとにだけ全体検出を行う。
+class PupilTracker {
+private:
+    double alpha;
+    double beta;
+    std::chrono::milliseconds max_coast;
+    int redetect_interval;
+    
+    PupilTrackState track_state;
+    cv::Point2f position;
+    cv::Point2f velocity; // px/s
+    std::chrono::steady_clock::time_point last_update;
+    std::chrono::steady_clock::time_point last_confirmed;
+    int frames_since_detection;
+    bool window_confirmed; // 直前の track() で小窓探索により確認した
+    
+    // 小窓探索の作業バッファ
+    cv::Mat window_blurred;
+    cv::Mat window_binary;
+    
+    uint64_t full_detections;
+    uint64_t window_confirmations;
+    uint64_t predicted_frames;
+
+public:
+    // coast_limit: 確認できないまま予測で進める上限（通常の瞬きより長くする）
+    PupilTracker(double position_gain = 0.7, double velocity_gain = 0.2,
+                 std::chrono::milliseconds coast_limit = std::chrono::milliseconds(400),
+                 int redetect_frames = 30);
+    
+    // 見つからなければ (-1, -1)。予測のみのフレームも (-1, -1) を返す（位置は predictedPosition()）
+    cv::Point2f track(PreprocessCache& cache, std::chrono::steady_clock::time_point timestamp,
+                      GazeEstimator& estimator);
+    void reset();
+    
+    PupilTrackState state() const { return track_state; }
+    // 直前の track() の Confirmed が小窓探索によるものか（全体検出の輪郭フォールバックは
+    // 閉じた目のまつ毛やまぶたの輪郭を拾うことがあるため、開眼の根拠にはしない）
+    bool confirmedByWindow() const { return window_confirmed; }
+    cv::Point2f predictedPosition() const { return position; }
+    
+    uint64_t fullDetections() const { return full_detections; }
+    uint64_t windowConfirmations() const { return window_confirmations; }
+    uint64_t predictedFrames() const { return predicted_frames; }
+
+private:
+    bool detectFull(PreprocessCache& cache, GazeEstimator& estimator, cv::Point2f& found);
+    bool searchWindow(PreprocessCache& cache, const cv::Point2f& predicted, cv::Point2f& found);
+    void initializeTrack(const cv::Point2f& measurement);
+    void correct(const cv::Point2f& predicted, const cv::Point2f& measurement, double dt);
+};
+
+#endif
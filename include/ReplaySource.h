@@ -0,0 +1,56 @@
+#ifndef REPLAYSOURCE_H
+#define REPLAYSOURCE_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include "FrameSource.h"
+
+enum class ReplayPacing {
+    Realtime,        // 記録時のフレームレートに合わせて供給
+    AsFastAsPossible // 待たずに供給（スループット計測用）
+};
+
+// 録画ファイルまたは連番画像ディレクトリからの再生入力
+// タイムスタンプはどちらのモードでも記録上の時刻を使うため、
+// 瞬き・タイムアウト判定が実行速度に依存せず再現できる
+class ReplaySource : public FrameSource {
+private:
+    cv::VideoCapture video;
+    std::vector<std::string> image_files;
+    size_t image_index;
+    bool is_image_sequence;
+    
+    ReplayPacing pacing;
+    double frame_rate;
+    uint64_t frame_index;
+    cv::Size frame_size;
+    
+    // Realtime 再生用: 最初のフレームを供給した実時刻と記録時刻
+    Clock::time_point wall_start;
+    Clock::duration recorded_start;
+    bool started;
+
+public:
+    ReplaySource();
+    
+    // path がディレクトリなら連番画像、それ以外は動画ファイルとして開く
+    // 連番画像と、フレームレートを返さない動画では default_fps を使う
+    bool open(const std::string& path, ReplayPacing pacing = ReplayPacing::Realtime,
+              double default_fps = 30.0);
+    
+    bool isOpened() const override;
+    void release() override;
+    bool read(cv::Mat& frame, Clock::time_point& timestamp) override;
+    bool skip() override;
+    cv::Size frameSize() const override { return frame_size; }
+    double fps() const override { return frame_rate; }
+    bool isLive() const override { return false; }
+    bool isPaced() const override { return pacing == ReplayPacing::Realtime; }
+
+private:
+    bool readNext(cv::Mat& frame, Clock::duration& recorded_time);
+    void waitForRecordedTime(Clock::duration recorded_time);
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <array>
+#include <cstddef>
+
+// 固定長のリングバッファ（単一スレッド用）
+// 満杯のときは最も古い要素を上書きするため、長時間動かしてもメモリは増えない
+template <typename T, size_t Capacity>
+class RingBuffer {
+private:
+    std::array<T, Capacity> slots;
+    size_t next_index; // 次に書く位置
+    size_t count;
+
+public:
+    RingBuffer() : next_index(0), count(0) {
+    }
+    
+    void push(const T& value) {
+        slots[next_index] = value;
+        next_index = (next_index + 1) % Capacity;
+        if (count < Capacity) {
+            count++;
+        }
+    }
+    
+    // age: 0 が最新、1 がその1つ前 ...（age < size() であること）
+    const T& recent(size_t age) const {
+        return slots[(next_index + Capacity - 1 - age) % Capacity];
+    }
+    
+    const T& newest() const { return recent(0); }
+    
+    void clear() {
+        next_index = 0;
+        count = 0;
+    }
+    
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    static constexpr size_t capacity() { return Capacity; }
+};
+
+#endif
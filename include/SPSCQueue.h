@@ -0,0 +1,65 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// 単一プロデューサ/単一コンシューマ用の固定長ロックフリーキュー
+// push は生産者スレッドのみ、pop は消費者スレッドのみから呼ぶこと
+template <typename T>
+class SPSCQueue {
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    std::vector<T> slots;
+    const size_t slot_count;
+
+    alignas(CACHE_LINE) std::atomic<size_t> head; // 次に読む位置（消費者）
+    alignas(CACHE_LINE) std::atomic<size_t> tail; // 次に書く位置（生産者）
+
+    size_t next(size_t index) const { return (index + 1 == slot_count) ? 0 : index + 1; }
+
+public:
+    explicit SPSCQueue(size_t capacity)
+        : slots(capacity + 1), slot_count(capacity + 1), head(0), tail(0) {
+    }
+
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    bool tryPush(T value) {
+        size_t current_tail = tail.load(std::memory_order_relaxed);
+        size_t next_tail = next(current_tail);
+        if (next_tail == head.load(std::memory_order_acquire)) {
+            return false; // 満杯
+        }
+        slots[current_tail] = std::move(value);
+        tail.store(next_tail, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& value) {
+        size_t current_head = head.load(std::memory_order_relaxed);
+        if (current_head == tail.load(std::memory_order_acquire)) {
+            return false; // 空
+        }
+        value = std::move(slots[current_head]);
+        slots[current_head] = T(); // 参照カウントを早めに手放す
+        head.store(next(current_head), std::memory_order_release);
+        return true;
+    }
+
+    // 現在の滞留数（他スレッドから見た近似値）
+    size_t size() const {
+        size_t h = head.load(std::memory_order_acquire);
+        size_t t = tail.load(std::memory_order_acquire);
+        return (t >= h) ? t - h : slot_count - h + t;
+    }
+
+    size_t capacity() const { return slot_count - 1; }
+    bool empty() const { return size() == 0; }
+};
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef SYNTHETICEYEGENERATOR_H
+#define SYNTHETICEYEGENERATOR_H
+
+#include <opencv2/opencv.hpp>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "FrameSource.h"
+
+// 合成目画像の描画パラメータ（座標はピクセル単位）
+struct SyntheticEyeParams {
+    cv::Size size = cv::Size(160, 120);
+    cv::Point2f pupil_center = cv::Point2f(80, 60);
+    float pupil_radius = 12.0f;
+    float iris_radius = 28.0f;
+    double iris_contrast = 0.6;    // 0: 白目と同じ明るさ, 1: 瞳孔と同じ暗さ
+    double eyelid_aperture = 1.0;  // 0: 完全に閉じた状態, 1: 全開
+    double noise_sigma = 4.0;      // ガウシアンノイズの標準偏差（輝度値）
+    int blur_kernel = 0;           // ガウシアンブラーのカーネルサイズ（0 で無効、奇数）
+    double brightness = 1.0;       // 全体の照明ゲイン
+    double lighting_gradient = 0.0; // 左右方向の照明ムラ（-1..1）
+    bool glint = true;             // 角膜反射の白点
+};
+
+// 描画結果の正解ラベル
+struct SyntheticEyeLabel {
+    cv::Point2f pupil_center;
+    float pupil_radius = 0;
+    double eyelid_aperture = 0;
+    bool pupil_visible = false; // 瞳孔中心がまぶたの内側にあるか
+    
+    // 68点ランドマークの目の6点と同じ並び
+    // p1: 目頭側の角, p2/p3: 上まぶた, p4: 目尻側の角, p5/p6: 下まぶた
+    std::array<cv::Point2f, 6> lid_landmarks;
+    double ear = 0; // lid_landmarks から求めた EAR
+};
+
+// パラメトリックな合成目画像の生成器
+// 作業バッファを保持して使い回すため、同じサイズで繰り返し描画しても確保は起きない
+class SyntheticEyeGenerator {
+private:
+    cv::RNG rng;
+    cv::Mat eye_layer;
+    cv::Mat lid_mask;
+    cv::Mat noise_buffer;
+    std::vector<cv::Point> lid_polygon;
+    std::vector<float> column_gain;
+
+public:
+    explicit SyntheticEyeGenerator(uint64_t seed = 0x5eed);
+    
+    void render(const SyntheticEyeParams& params, cv::Mat& image, SyntheticEyeLabel& label);
+    
+    // サイズに応じた妥当な範囲でパラメータをランダムに選ぶ
+    SyntheticEyeParams randomParams(const cv::Size& size, double closed_probability = 0.1);
+    
+    static double computeEAR(const std::array<cv::Point2f, 6>& landmarks);
+
+private:
+    void computeLidShape(const SyntheticEyeParams& params, SyntheticEyeLabel& label);
+    void applyLighting(const SyntheticEyeParams& params, cv::Mat& image);
+};
+
+// 合成画像をその場で生成するフレーム入力
+// 瞳孔はリサージュ曲線で動き、一定間隔で瞬き（2回連続の瞬きを含む）を入れる
+class SyntheticEyeSource : public FrameSource {
+private:
+    SyntheticEyeGenerator generator;
+    SyntheticEyeParams base_params;
+    SyntheticEyeLabel last_label;
+    double frame_rate;
+    uint64_t frame_index;
+    uint64_t frame_limit; // 0 なら無制限
+    bool opened;
+
+public:
+    SyntheticEyeSource(const cv::Size& size = cv::Size(640, 480), double fps = 30.0,
+                       uint64_t frame_count = 0, uint64_t seed = 0x5eed);
+    
+    bool isOpened() const override { return opened; }
+    void release() override { opened = false; }
+    bool read(cv::Mat& frame, Clock::time_point& timestamp) override;
+    bool skip() override;
+    cv::Size frameSize() const override { return base_params.size; }
+    double fps() const override { return frame_rate; }
+    bool isLive() const override { return false; }
+    
+    // 直前に生成したフレームの正解ラベル
+    const SyntheticEyeLabel& lastLabel() const { return last_label; }
+
+private:
+    SyntheticEyeParams paramsAt(uint64_t index) const;
+};
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef TRACKERSESSION_H
+#define TRACKERSESSION_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include "BlinkDetector.h"
+#include "CommandController.h"
+#include "Config.h"
+#include "FramePacket.h"
+#include "FramePool.h"
+#include "FrameSource.h"
+#include "GazeEstimator.h"
+#include "Metrics.h"
+#include "PreprocessCache.h"
+#include "PupilTracker.h"
+#include "WorkStealingPool.h"
+
+// 1台のカメラ（1席）分のトラッカー
+// 瞬き・視線・コマンドの状態はセッションごとに持ち、フレームごとの解析は共有のプールで行う。
+// プールに積む解析タスクは常に1セッション1つまでで、解析が追いつかなければ最新のフレームだけを解析する。
+// 読み込みで待つ入力（ライブ入力・実時間の再生）はセッションごとの取得スレッドで読み、共有のワーカーを眠らせない。
+// プレビュー・ポインタモード・キャリブレーションの保存は扱わない（1席の EyeTracker を使う）。
+class TrackerSession {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    static const size_t POOL_SIZE = 4; // 取得中・受け渡し中・解析中 + 予備
+    
+    std::string session_name;
+    std::unique_ptr<FrameSource> source;
+    std::unique_ptr<BlinkDetector> blink_detector;
+    std::unique_ptr<GazeEstimator> gaze_estimator;
+    std::unique_ptr<CommandController> command_controller;
+    bool command_mode_active;       // 解析タスク専用
+    PreprocessCache preprocess_cache; // 解析タスク専用
+    PupilTracker pupil_tracker;       // 解析タスク専用
+    std::unique_ptr<FramePool> frame_pool;
+    PipelineMetrics metrics;
+    
+    WorkStealingPool* pool;
+    bool paced;                  // 読み込みで待つ入力か（FrameSource::isPaced）
+    std::thread capture_thread;  // 待つ入力のみ（待たない記録済み入力は解析タスクの中で読む）
+    FramePacketPtr latest_frame; // 取得 -> 解析の受け渡し（std::atomic_exchange で扱う）
+    FramePacketPtr read_packet;  // 記録済み入力の読み込み先（解析タスク専用）
+    std::atomic<bool> task_scheduled; // 解析タスクがプールに積まれているか実行中
+    std::atomic<int> tasks_in_flight; // 実行を終えていないタスク（stop() はこれが 0 になるまで待つ）
+    Clock::time_point scheduled_at;   // 解析タスクを積んだ時刻（プールでの待ちの計測用）
+    std::atomic<bool> running;
+    std::atomic<bool> finished;
+    Clock::time_point started_at;
+    std::atomic<int64_t> finished_at_ns; // 終了時刻（started_at からの経過）
+
+public:
+    // key_backend が nullptr ならプラットフォームの既定バックエンドを使う
+    TrackerSession(std::string name, std::unique_ptr<FrameSource> frame_source,
+                   std::unique_ptr<KeyBackend> key_backend = nullptr);
+    ~TrackerSession();
+    
+    TrackerSession(const TrackerSession&) = delete;
+    TrackerSession& operator=(const TrackerSession&) = delete;
+    
+    // start() の前に呼ぶ（カメラ設定は使わない。入力は開いた状態で渡す）
+    void applyConfig(const EyeTrackingConfig& config);
+    
+    bool start(WorkStealingPool& worker_pool);
+    // 取得を止め、実行中の解析タスクが終わるまで待つ
+    void stop();
+    // 入力の終端に達したか、取得に失敗した
+    bool isFinished() const { return finished.load(std::memory_order_acquire); }
+    
+    const std::string& name() const { return session_name; }
+    const PipelineMetrics& getMetrics() const { return metrics; }
+    uint64_t framesAnalyzed() const { return metrics.counterValue(MetricCounter::FramesAnalyzed); }
+    // 開始から終了まで（実行中なら現在まで）の時間
+    double elapsedSeconds() const;
+
+private:
+    void captureLoop();
+    void reportCaptureEnd();
+    void schedule();
+    void runTask();
+    bool readRecordedFrame(FramePacketPtr& packet);
+    void processFrame(FramePacket& packet);
+    void markFinished();
+};
+
+#endif
@@ -2,28 +2,31 @@
 #define UTILS_H
 
 #include <string>
+#include <chrono>
 #include <opencv2/opencv.hpp>
+#include "FrameAnalysis.h"
+
+struct EyeTrackingConfig;
 
 class Utils {
 public:
     static std::string getConfigPath();
     static std::string getDataPath();
-    static bool loadConfig(const std::string& config_path);
+    // 読めれば config を上書きして true。読めない・不正なら config はそのまま
+    static bool loadConfig(const std::string& config_path, EyeTrackingConfig& config);
     
     static void saveCalibrationData(const std::string& filename, 
                                    const cv::Point2f& baseline);
     static cv::Point2f loadCalibrationData(const std::string& filename);
     
-    static void drawDebugInfo(cv::Mat& frame, 
-                             const cv::Point2f& pupil_pos,
-                             const cv::Point2f& gaze_direction,
-                             bool command_active);
+    static void drawDebugInfo(cv::Mat& frame, const FrameAnalysis& analysis);
     
     static double calculateFPS();
-    
+
 private:
     static std::chrono::steady_clock::time_point last_time;
     static int frame_count;
+    static double last_fps;
 };
 
 #endif
@@ -0,0 +1,62 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 複数のトラッカーで共有するスレッドプール
+// ワーカーごとにキューを持ち、自分のキューが空になったら他のワーカーのキューから取る。
+// ワーカーの中から submit したタスクは同じワーカーのキューに積む（同じストリームの続きが同じコアに残りやすい）。
+// どのキューも古いものから取り出すため、先に積まれたタスクが後回しにされ続けることはない。
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+    
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<bool> running;
+    std::atomic<size_t> queued;     // 全キューに積まれているタスクの数
+    std::atomic<size_t> next_queue; // ワーカー以外からの submit の振り分け先
+    // 起床通知用（キューの操作はワーカーごとの mutex で行う）
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    
+    std::atomic<uint64_t> executed_count;
+    std::atomic<uint64_t> stolen_count;
+
+public:
+    // thread_count が 0 ならコア数
+    explicit WorkStealingPool(size_t thread_count = 0);
+    // 積まれているタスクを実行し終えてからワーカーを止める
+    ~WorkStealingPool();
+    
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+    
+    void submit(Task task);
+    
+    size_t threadCount() const { return threads.size(); }
+    uint64_t executedCount() const { return executed_count.load(std::memory_order_relaxed); }
+    // 他のワーカーのキューから取って実行した数
+    uint64_t stolenCount() const { return stolen_count.load(std::memory_order_relaxed); }
+
+private:
+    void workerLoop(size_t index);
+    bool takeTask(size_t index, Task& task);
+    static bool popFront(WorkerQueue& queue, Task& task);
+};
+
+#endif
@@ -1,22 +1,82 @@
 #include "BlinkDetector.h"
+#include "Config.h"
 #include <algorithm>
 #include <iostream>
 
+namespace {
+
+// 分散がこの割合（最小〜最大の間）を超える行・列を目の開口部とみなす
+const double PROFILE_LEVEL_RATIO = 0.2;
+
+// 閾値を超える区間の長さ（最初と最後の位置の差）
+int profileExtent(const std::vector<double>& profile) {
+    auto range = std::minmax_element(profile.begin(), profile.end());
+    if (*range.second <= *range.first) {
+        return 0;
+    }
+    double threshold = *range.first + (*range.second - *range.first) * PROFILE_LEVEL_RATIO;
+    
+    int first = -1;
+    int last = -1;
+    for (int i = 0; i < static_cast<int>(profile.size()); i++) {
+        if (profile[i] > threshold) {
+            if (first < 0) {
+                first = i;
+            }
+            last = i;
+        }
+    }
+    return first < 0 ? 0 : last - first + 1;
+}
+
+}
+
 BlinkDetector::BlinkDetector(double threshold, int frames) 
     : ear_threshold(threshold), consecutive_frames(frames), 
-      frame_counter(0), is_blinking(false) {
+      frame_counter(0), is_blinking(false), gesture_recognizer(frames),
+      openness_metric(OpennessMetric::ContourEAR) {
+}
+
+void BlinkDetector::configure(const BlinkConfig& config) {
+    ear_threshold = config.ear_threshold;
+    consecutive_frames = config.consecutive_frames;
+    openness_metric = config.openness_metric;
+    gesture_recognizer.configure(config.consecutive_frames,
+                                 std::chrono::milliseconds(config.long_blink_ms),
+                                 std::chrono::milliseconds(config.max_blink_interval_ms));
 }
 
 bool BlinkDetector::detectBlink(const cv::Mat& eye_roi) {
-    double ear = calculateEAR(eye_roi);
+    return detectBlink(calculateEAR(eye_roi));
+}
+
+bool BlinkDetector::detectBlink(FrameAnalysis& analysis) {
+    // 予測位置の付近の小窓で瞳孔を確認できている間は目が開いているので、EAR の低下は輪郭抽出の失敗とみなす
+    // （閉じた目は Predicted、追跡の失敗は Lost になり、どちらも EAR で判定する。
+    //   全体検出による Confirmed は輪郭フォールバックがまつ毛やまぶたを拾うことがあるため EAR に従う）
+    double ear = analysis.ear;
+    if (analysis.pupil_track_state == PupilTrackState::Confirmed && analysis.pupil_window_confirmed) {
+        ear = std::max(ear, ear_threshold);
+    }
     
+    analysis.blink_detected = detectBlink(ear);
+    
+    // 片目の映像なので左右とも同じ開閉を渡す（ウインクは判定されない）
+    analysis.gesture = detectGesture(ear, ear, analysis.timestamp);
+    analysis.double_blink = analysis.gesture == BlinkGesture::DoubleBlink;
+    return analysis.blink_detected;
+}
+
+BlinkGesture BlinkDetector::detectGesture(double left_ear, double right_ear,
+                                          std::chrono::steady_clock::time_point now) {
+    return gesture_recognizer.update(left_ear < ear_threshold, right_ear < ear_threshold, now);
+}
+
+bool BlinkDetector::detectBlink(double ear) {
     if (ear < ear_threshold) {
         frame_counter++;
         if (frame_counter >= consecutive_frames && !is_blinking) {
             is_blinking = true;
-            auto now = std::chrono::steady_clock::now();
-            blink_times.push_back(now);
-            last_blink_time = now;
             return true;
         }
     } else {
@@ -30,7 +90,12 @@ bool BlinkDetector::detectBlink(const cv::Mat& eye_roi) {
 }
 
 double BlinkDetector::calculateEAR(const cv::Mat& eye_roi) {
-    std::vector<cv::Point> eye_contour = extractEyeContour(eye_roi);
+    PreprocessCache cache(eye_roi);
+    return calculateEAR(cache);
+}
+
+double BlinkDetector::calculateEAR(PreprocessCache& cache) {
+    const std::vector<cv::Point>& eye_contour = extractEyeContour(cache);
     
     if (eye_contour.size() < 6) {
         return 1.0; // デフォルト値（目が開いている状態）
@@ -46,58 +111,87 @@ double BlinkDetector::calculateEAR(const cv::Mat& eye_roi) {
     return ear;
 }
 
-bool BlinkDetector::checkDoubleBlinkPattern() {
-    if (blink_times.size() < 2) {
-        return false;
+double BlinkDetector::calculateOpenness(PreprocessCache& cache) {
+    if (openness_metric == OpennessMetric::ProjectionProfile) {
+        return calculateProjectionOpenness(cache);
+    }
+    return calculateEAR(cache);
+}
+
+double BlinkDetector::calculateProjectionOpenness(PreprocessCache& cache) {
+    const cv::Mat& gray = cache.gray();
+    const int rows = gray.rows;
+    const int cols = gray.cols;
+    if (rows < 2 || cols < 2) {
+        return 1.0;
     }
     
-    auto now = std::chrono::steady_clock::now();
-    auto recent_blinks = blink_times;
-    
-    // 古い瞬きデータを削除（5秒以上前）
-    recent_blinks.erase(
-        std::remove_if(recent_blinks.begin(), recent_blinks.end(),
-        [now](const std::chrono::steady_clock::time_point& blink_time) {
-            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - blink_time);
-            return duration.count() > 5000;
-        }),
-        recent_blinks.end()
-    );
-    
-    if (recent_blinks.size() >= 2) {
-        auto last_two = recent_blinks.end() - 2;
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-            recent_blinks.back() - *last_two);
-        
-        if (duration.count() >= MIN_BLINK_INTERVAL_MS && 
-            duration.count() <= MAX_BLINK_INTERVAL_MS) {
-            blink_times.clear(); // パターン検出後にリセット
-            return true;
+    column_sum.assign(cols, 0);
+    column_square_sum.assign(cols, 0);
+    row_variance.resize(rows);
+    column_variance.resize(cols);
+    
+    // 1回の走査で行ごとと列ごとの和・二乗和を同時に集計する
+    // （内側のループは分岐のない整数演算なのでコンパイラがベクトル化できる）
+    uint32_t* col_sum = column_sum.data();
+    uint32_t* col_square = column_square_sum.data();
+    for (int y = 0; y < rows; y++) {
+        const uchar* row = gray.ptr<uchar>(y);
+        uint32_t row_sum = 0;
+        uint32_t row_square = 0;
+        for (int x = 0; x < cols; x++) {
+            uint32_t value = row[x];
+            uint32_t square = value * value;
+            col_sum[x] += value;
+            col_square[x] += square;
+            row_sum += value;
+            row_square += square;
         }
+        double mean = static_cast<double>(row_sum) / cols;
+        row_variance[y] = static_cast<double>(row_square) / cols - mean * mean;
+    }
+    for (int x = 0; x < cols; x++) {
+        double mean = static_cast<double>(col_sum[x]) / rows;
+        column_variance[x] = static_cast<double>(col_square[x]) / rows - mean * mean;
     }
     
-    return false;
+    // 白目・虹彩・瞳孔が並ぶ開口部は行方向にも列方向にも分散が大きい
+    int height = profileExtent(row_variance);
+    int width = profileExtent(column_variance);
+    if (width == 0) {
+        return 1.0; // 判定できないときは開いているとみなす（EAR と同じ扱い）
+    }
+    
+    // まぶたを放物線とみると、EAR は縦横比のおよそ 0.9 倍になる
+    const double EAR_PER_ASPECT = 0.89;
+    return EAR_PER_ASPECT * height / width;
 }
 
-std::vector<cv::Point> BlinkDetector::extractEyeContour(const cv::Mat& eye_roi) {
-    cv::Mat gray, binary;
-    cv::cvtColor(eye_roi, gray, cv::COLOR_BGR2GRAY);
-    cv::threshold(gray, binary, 0, 255, cv::THRESH_BINARY + cv::THRESH_OTSU);
+const std::vector<cv::Point>& BlinkDetector::extractEyeContour(PreprocessCache& cache) {
+    static const std::vector<cv::Point> empty_contour;
+    
+    // グレースケール化と大津の二値化は GazeEstimator と共有するキャッシュから取得
+    const cv::Mat& binary = cache.otsuBinary();
     
-    std::vector<std::vector<cv::Point>> contours;
+    MatArena::Contours& contours = cache.arena().contours(MatArena::CONTOURS_EYE);
     cv::findContours(binary, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
     
     if (contours.empty()) {
-        return std::vector<cv::Point>();
+        return empty_contour;
     }
     
-    // 最大の輪郭を目の輪郭として選択
-    auto max_contour = *std::max_element(contours.begin(), contours.end(),
-        [](const std::vector<cv::Point>& a, const std::vector<cv::Point>& b) {
-            return cv::contourArea(a) < cv::contourArea(b);
-        });
+    // 最大の輪郭を目の輪郭として選択（アリーナ内の輪郭を参照で返す）
+    size_t max_index = 0;
+    double max_area = -1.0;
+    for (size_t i = 0; i < contours.size(); i++) {
+        double area = cv::contourArea(contours[i]);
+        if (area > max_area) {
+            max_area = area;
+            max_index = i;
+        }
+    }
     
-    return max_contour;
+    return contours[max_index];
 }
 
 double BlinkDetector::euclideanDistance(const cv::Point& p1, const cv::Point& p2) {
@@ -105,7 +199,7 @@ double BlinkDetector::euclideanDistance(const cv::Point& p1, const cv::Point& p2
 }
 
 void BlinkDetector::reset() {
-    blink_times.clear();
+    gesture_recognizer.reset();
     frame_counter = 0;
     is_blinking = false;
 }
@@ -0,0 +1,151 @@
+#include "BlinkGesture.h"
+
+namespace {
+
+using Gesture = BlinkGesture;
+using R = BlinkGestureRecognizer;
+
+}
+
+// 状態遷移表: [現在の状態][入力] -> {次の状態, 通知するジェスチャ}
+// 入力の並び: 開いた, 両目を閉じた, 左目だけ閉じた, 右目だけ閉じた, 長押し時間経過, 間隔時間経過
+const BlinkGestureRecognizer::Transition BlinkGestureRecognizer::TABLE[STATE_COUNT][INPUT_COUNT] = {
+    // STATE_IDLE
+    {{R::STATE_IDLE, Gesture::None}, {R::STATE_CLOSED_1, Gesture::None},
+     {R::STATE_WINK_LEFT, Gesture::None}, {R::STATE_WINK_RIGHT, Gesture::None},
+     {R::STATE_IDLE, Gesture::None}, {R::STATE_IDLE, Gesture::None}},
+    // STATE_CLOSED_1（片目だけ先に開いても閉じたままとみなす）
+    {{R::STATE_OPEN_1, Gesture::None}, {R::STATE_CLOSED_1, Gesture::None},
+     {R::STATE_CLOSED_1, Gesture::None}, {R::STATE_CLOSED_1, Gesture::None},
+     {R::STATE_LONG_HELD, Gesture::LongBlink}, {R::STATE_CLOSED_1, Gesture::None}},
+    // STATE_OPEN_1（間隔内に2回目が閉じたらその時点でダブル瞬き。来なければ単発の瞬きとして捨てる）
+    {{R::STATE_OPEN_1, Gesture::None}, {R::STATE_CLOSED_2, Gesture::DoubleBlink},
+     {R::STATE_WINK_LEFT, Gesture::None}, {R::STATE_WINK_RIGHT, Gesture::None},
+     {R::STATE_OPEN_1, Gesture::None}, {R::STATE_IDLE, Gesture::None}},
+    // STATE_CLOSED_2（通知済みなので長く閉じていても長い瞬きにはしない）
+    {{R::STATE_OPEN_2, Gesture::None}, {R::STATE_CLOSED_2, Gesture::None},
+     {R::STATE_CLOSED_2, Gesture::None}, {R::STATE_CLOSED_2, Gesture::None},
+     {R::STATE_LONG_HELD, Gesture::None}, {R::STATE_CLOSED_2, Gesture::None}},
+    // STATE_OPEN_2（間隔内に3回目が閉じたらトリプル瞬き。来なければダブル瞬きで終わり）
+    {{R::STATE_OPEN_2, Gesture::None}, {R::STATE_CLOSED_3, Gesture::TripleBlink},
+     {R::STATE_WINK_LEFT, Gesture::None}, {R::STATE_WINK_RIGHT, Gesture::None},
+     {R::STATE_OPEN_2, Gesture::None}, {R::STATE_IDLE, Gesture::None}},
+    // STATE_CLOSED_3
+    {{R::STATE_IDLE, Gesture::None}, {R::STATE_CLOSED_3, Gesture::None},
+     {R::STATE_CLOSED_3, Gesture::None}, {R::STATE_CLOSED_3, Gesture::None},
+     {R::STATE_LONG_HELD, Gesture::None}, {R::STATE_CLOSED_3, Gesture::None}},
+    // STATE_LONG_HELD
+    {{R::STATE_IDLE, Gesture::None}, {R::STATE_LONG_HELD, Gesture::None},
+     {R::STATE_LONG_HELD, Gesture::None}, {R::STATE_LONG_HELD, Gesture::None},
+     {R::STATE_LONG_HELD, Gesture::None}, {R::STATE_LONG_HELD, Gesture::None}},
+    // STATE_WINK_LEFT（もう片方も閉じたら瞬きとして扱う）
+    {{R::STATE_IDLE, Gesture::LeftWink}, {R::STATE_CLOSED_1, Gesture::None},
+     {R::STATE_WINK_LEFT, Gesture::None}, {R::STATE_WINK_RIGHT, Gesture::None},
+     {R::STATE_LONG_HELD, Gesture::None}, {R::STATE_WINK_LEFT, Gesture::None}},
+    // STATE_WINK_RIGHT
+    {{R::STATE_IDLE, Gesture::RightWink}, {R::STATE_CLOSED_1, Gesture::None},
+     {R::STATE_WINK_LEFT, Gesture::None}, {R::STATE_WINK_RIGHT, Gesture::None},
+     {R::STATE_LONG_HELD, Gesture::None}, {R::STATE_WINK_RIGHT, Gesture::None}},
+};
+
+BlinkGestureRecognizer::BlinkGestureRecognizer(int stable_frames, std::chrono::milliseconds long_duration,
+                                               std::chrono::milliseconds interval)
+    : min_frames(stable_frames), long_blink(long_duration), max_interval(interval) {
+    reset();
+}
+
+void BlinkGestureRecognizer::configure(int stable_frames, std::chrono::milliseconds long_duration,
+                                       std::chrono::milliseconds interval) {
+    min_frames = stable_frames;
+    long_blink = long_duration;
+    max_interval = interval;
+}
+
+void BlinkGestureRecognizer::reset() {
+    state = STATE_IDLE;
+    stable_input = INPUT_OPEN;
+    candidate_input = INPUT_OPEN;
+    candidate_frames = 0;
+    history.clear();
+}
+
+const char* BlinkGestureRecognizer::gestureName(BlinkGesture gesture) {
+    switch (gesture) {
+        case BlinkGesture::DoubleBlink: return "double blink";
+        case BlinkGesture::TripleBlink: return "triple blink";
+        case BlinkGesture::LongBlink: return "long blink";
+        case BlinkGesture::LeftWink: return "left wink";
+        case BlinkGesture::RightWink: return "right wink";
+        default: return "none";
+    }
+}
+
+bool BlinkGestureRecognizer::isClosedState(State s) const {
+    return s == STATE_CLOSED_1 || s == STATE_CLOSED_2 || s == STATE_CLOSED_3 ||
+           s == STATE_LONG_HELD || s == STATE_WINK_LEFT || s == STATE_WINK_RIGHT;
+}
+
+BlinkGesture BlinkGestureRecognizer::update(bool left_closed, bool right_closed, Clock::time_point now) {
+    Input input = INPUT_OPEN;
+    if (left_closed && right_closed) {
+        input = INPUT_BOTH_CLOSED;
+    } else if (left_closed) {
+        input = INPUT_LEFT_CLOSED;
+    } else if (right_closed) {
+        input = INPUT_RIGHT_CLOSED;
+    }
+    
+    // 同じ開閉が min_frames 続いたら確定する（時刻は続き始めたフレームのもの）
+    if (input != candidate_input) {
+        candidate_input = input;
+        candidate_frames = 0;
+        candidate_since = now;
+    }
+    candidate_frames++;
+    if (candidate_frames >= min_frames && candidate_input != stable_input) {
+        stable_input = candidate_input;
+        return apply(stable_input, candidate_since);
+    }
+    
+    // 時間経過による遷移
+    if (state != STATE_LONG_HELD && isClosedState(state) && now - closed_since >= long_blink) {
+        return apply(INPUT_LONG_TIMEOUT, now);
+    }
+    if ((state == STATE_OPEN_1 || state == STATE_OPEN_2) && now - last_blink_start > max_interval) {
+        return apply(INPUT_GAP_TIMEOUT, now);
+    }
+    return BlinkGesture::None;
+}
+
+BlinkGesture BlinkGestureRecognizer::apply(Input input, Clock::time_point at) {
+    const Transition& transition = TABLE[state][input];
+    State previous = state;
+    state = transition.next;
+    
+    bool was_closed = isClosedState(previous);
+    bool is_closed = isClosedState(state);
+    if (!was_closed && is_closed) {
+        closed_since = at;
+    }
+    
+    bool was_blink = previous == STATE_CLOSED_1 || previous == STATE_CLOSED_2 || previous == STATE_CLOSED_3;
+    bool is_blink = state == STATE_CLOSED_1 || state == STATE_CLOSED_2 || state == STATE_CLOSED_3;
+    if (!was_blink && is_blink) {
+        last_blink_start = at;
+    }
+    
+    // 目が開いたら1回分の閉じを履歴に残す
+    if (was_closed && !is_closed) {
+        BlinkEvent event;
+        event.start = closed_since;
+        event.end = at;
+        if (previous == STATE_WINK_LEFT) {
+            event.eye = BlinkEvent::Eye::Left;
+        } else if (previous == STATE_WINK_RIGHT) {
+            event.eye = BlinkEvent::Eye::Right;
+        }
+        history.push(event);
+    }
+    
+    return transition.emit;
+}
@@ -0,0 +1,237 @@
+#include "CalibrationStore.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char MAGIC[8] = {'E', 'Y', 'E', 'C', 'A', 'L', 'B', '\0'};
+
+struct StoreHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;   // 版が同じでもレコード長が違えば読まない（ビルド間の不一致の検出）
+    uint32_t record_count;
+    uint32_t checksum;      // レコード部の FNV-1a
+};
+
+static_assert(sizeof(StoreHeader) == 24, "StoreHeader layout is part of the file format");
+
+uint32_t fnv1a(const unsigned char* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+}
+
+CalibrationStore::CalibrationStore()
+    : mapped_data(nullptr), mapped_size(0), records(nullptr), record_count(0)
+#ifdef _WIN32
+    , file_handle(nullptr), mapping_handle(nullptr)
+#endif
+{
+}
+
+CalibrationStore::~CalibrationStore() {
+    close();
+}
+
+bool CalibrationStore::open(const std::string& store_path) {
+    close();
+    path = store_path;
+    return mapFile();
+}
+
+void CalibrationStore::close() {
+    unmapFile();
+}
+
+const CalibrationRecord* CalibrationStore::find(const std::string& user) const {
+    // プロファイルは数件なので線形探索で十分（比較はマップ上のレコードに対して直接行う）
+    for (uint32_t i = 0; i < record_count; i++) {
+        if (strncmp(records[i].user, user.c_str(), CalibrationRecord::USER_NAME_SIZE) == 0) {
+            return &records[i];
+        }
+    }
+    return nullptr;
+}
+
+bool CalibrationStore::put(const CalibrationRecord& record) {
+    std::vector<CalibrationRecord> profiles(records, records + record_count);
+    
+    bool replaced = false;
+    for (auto& existing : profiles) {
+        if (strncmp(existing.user, record.user, CalibrationRecord::USER_NAME_SIZE) == 0) {
+            existing = record;
+            replaced = true;
+        }
+    }
+    if (!replaced) {
+        profiles.push_back(record);
+    }
+    
+    // Windows ではマップ中のファイルを置き換えられないため、先に閉じてから書く
+    // （失敗した場合は古いファイルがそのまま残るので、開き直せば元に戻る）
+    unmapFile();
+    bool written = writeFile(profiles);
+    return mapFile() && written;
+}
+
+void CalibrationStore::setUserName(CalibrationRecord& record, const std::string& user) {
+    memset(record.user, 0, sizeof(record.user));
+    strncpy(record.user, user.c_str(), CalibrationRecord::USER_NAME_SIZE - 1);
+}
+
+bool CalibrationStore::mapFile() {
+    size_t size = 0;
+    const unsigned char* data = nullptr;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return true; // まだ保存されていない
+    }
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(file, &file_size);
+    size = static_cast<size_t>(file_size.QuadPart);
+    HANDLE mapping = size > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    if (mapping) {
+        data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (!data) {
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        std::cerr << "Failed to map calibration store: " << path << std::endl;
+        return false;
+    }
+    file_handle = file;
+    mapping_handle = mapping;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return true; // まだ保存されていない
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        std::cerr << "Calibration store is empty: " << path << std::endl;
+        return false;
+    }
+    size = static_cast<size_t>(st.st_size);
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // マップは fd を閉じても有効
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Failed to map calibration store: " << path << std::endl;
+        return false;
+    }
+    data = static_cast<const unsigned char*>(mapped);
+#endif
+
+    mapped_data = data;
+    mapped_size = size;
+    
+    // ヘッダとチェックサムだけを確かめ、レコードはマップ上をそのまま参照する
+    StoreHeader header;
+    if (size < sizeof(header)) {
+        std::cerr << "Calibration store is truncated: " << path << std::endl;
+        unmapFile();
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != FORMAT_VERSION ||
+        header.record_size != sizeof(CalibrationRecord)) {
+        std::cerr << "Unsupported calibration store format: " << path << std::endl;
+        unmapFile();
+        return false;
+    }
+    size_t body_size = static_cast<size_t>(header.record_count) * sizeof(CalibrationRecord);
+    if (size != sizeof(header) + body_size || fnv1a(data + sizeof(header), body_size) != header.checksum) {
+        std::cerr << "Calibration store is corrupted: " << path << std::endl;
+        unmapFile();
+        return false;
+    }
+    
+    // ヘッダ長は 8 の倍数なので、レコードの境界合わせはそのまま満たされる
+    records = reinterpret_cast<const CalibrationRecord*>(data + sizeof(header));
+    record_count = header.record_count;
+    return true;
+}
+
+void CalibrationStore::unmapFile() {
+    if (mapped_data) {
+#ifdef _WIN32
+        UnmapViewOfFile(mapped_data);
+        CloseHandle(static_cast<HANDLE>(mapping_handle));
+        CloseHandle(static_cast<HANDLE>(file_handle));
+        mapping_handle = nullptr;
+        file_handle = nullptr;
+#else
+        munmap(const_cast<unsigned char*>(mapped_data), mapped_size);
+#endif
+    }
+    mapped_data = nullptr;
+    mapped_size = 0;
+    records = nullptr;
+    record_count = 0;
+}
+
+bool CalibrationStore::writeFile(const std::vector<CalibrationRecord>& profiles) const {
+    StoreHeader header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.record_size = sizeof(CalibrationRecord);
+    header.record_count = static_cast<uint32_t>(profiles.size());
+    header.checksum = fnv1a(reinterpret_cast<const unsigned char*>(profiles.data()),
+                            profiles.size() * sizeof(CalibrationRecord));
+    
+    std::string temp_path = path + ".tmp";
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent, ec);
+    }
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Failed to write calibration store: " << temp_path << std::endl;
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(profiles.data()),
+                   static_cast<std::streamsize>(profiles.size() * sizeof(CalibrationRecord)));
+        if (!file) {
+            std::cerr << "Failed to write calibration store: " << temp_path << std::endl;
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    if (!MoveFileExA(temp_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+#else
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+#endif
+        std::cerr << "Failed to replace calibration store: " << path << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
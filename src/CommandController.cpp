@@ -1,20 +1,28 @@
 #include "CommandController.h"
+#include "Config.h"
+#include <cmath>
 #include <iostream>
 
-#ifdef _WIN32
-#include <windows.h>
-#elif __linux__
-#include <X11/Xlib.h>
-#include <X11/extensions/XTest.h>
-#include <X11/keysym.h>
-#endif
+CommandController::CommandController(std::unique_ptr<KeyBackend> backend)
+    : command_active(false), command_timeout_ms(5000) {
+    if (!backend) {
+        backend = createDefaultKeyBackend();
+    }
+    key_injector = std::make_unique<KeyInjector>(std::move(backend));
+    key_injector->start();
+}
 
-CommandController::CommandController() : command_active(false) {
+void CommandController::configure(const GazeConfig& config) {
+    command_timeout_ms = config.command_timeout_ms;
 }
 
 void CommandController::activateCommandMode() {
+    activateCommandMode(std::chrono::steady_clock::now());
+}
+
+void CommandController::activateCommandMode(std::chrono::steady_clock::time_point now) {
     command_active = true;
-    activation_time = std::chrono::steady_clock::now();
+    activation_time = now;
 }
 
 void CommandController::deactivateCommandMode() {
@@ -22,85 +30,67 @@ void CommandController::deactivateCommandMode() {
 }
 
 bool CommandController::isCommandModeActive() const {
+    return isCommandModeActive(std::chrono::steady_clock::now());
+}
+
+bool CommandController::isCommandModeActive(std::chrono::steady_clock::time_point now) const {
     if (!command_active) {
         return false;
     }
     
     // タイムアウトチェック
-    auto now = std::chrono::steady_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
         now - activation_time);
     
-    return duration.count() < COMMAND_TIMEOUT_MS;
+    return duration.count() < command_timeout_ms;
 }
 
-void CommandController::executeDirectionCommand(cv::Point2f direction) {
+bool CommandController::executeDirectionCommand(cv::Point2f direction) {
     if (!isCommandModeActive()) {
-        return;
+        return false;
     }
     
-    sendArrowKey(direction);
+    sendArrowKey(direction, std::chrono::steady_clock::now());
+    return true;
 }
 
-void CommandController::sendArrowKey(cv::Point2f direction) {
+bool CommandController::executeDirectionCommand(const FrameAnalysis& analysis) {
+    // タイムアウトはフレームの時刻で判定する（再生時も再現可能にするため）
+    if (!isCommandModeActive(analysis.timestamp)) {
+        return false;
+    }
+    
+    // 遅延の起点はフレームの撮影時刻（再生時の記録上の時刻ではなく実時刻）
+    sendArrowKey(analysis.gaze_direction, analysis.capture_time);
+    return true;
+}
+
+void CommandController::sendArrowKey(cv::Point2f direction, std::chrono::steady_clock::time_point requested) {
     // 最も強い方向成分を選択
     double abs_x = abs(direction.x);
     double abs_y = abs(direction.y);
+    InjectedKey key;
     
     if (abs_x > abs_y) {
         // 左右の動き
         if (direction.x > 0) {
             std::cout << "→ Right" << std::endl;
-#ifdef _WIN32
-            sendWindowsKey(VK_RIGHT);
-#elif __linux__
-            sendLinuxKey(XK_Right);
-#endif
+            key = InjectedKey::Right;
         } else {
             std::cout << "← Left" << std::endl;
-#ifdef _WIN32
-            sendWindowsKey(VK_LEFT);
-#elif __linux__
-            sendLinuxKey(XK_Left);
-#endif
+            key = InjectedKey::Left;
         }
     } else {
         // 上下の動き
         if (direction.y > 0) {
             std::cout << "↓ Down" << std::endl;
-#ifdef _WIN32
-            sendWindowsKey(VK_DOWN);
-#elif __linux__
-            sendLinuxKey(XK_Down);
-#endif
+            key = InjectedKey::Down;
         } else {
             std::cout << "↑ Up" << std::endl;
-#ifdef _WIN32
-            sendWindowsKey(VK_UP);
-#elif __linux__
-            sendLinuxKey(XK_Up);
-#endif
+            key = InjectedKey::Up;
         }
     }
+    
+    // キューに積むだけで戻る（押下・解放は送信スレッドが行う）
+    key_injector->send(key, requested);
 }
-
-#ifdef _WIN32
-void CommandController::sendWindowsKey(int vk_code) {
-    keybd_event(vk_code, 0, 0, 0);
-    Sleep(50);
-    keybd_event(vk_code, 0, KEYEVENTF_KEYUP, 0);
-}
-#elif __linux__
-void CommandController::sendLinuxKey(int key_code) {
-    Display* display = XOpenDisplay(nullptr);
-    if (display) {
-        KeyCode keycode = XKeysymToKeycode(display, key_code);
-        XTestFakeKeyEvent(display, keycode, True, 0);
-        XFlush(display);
-        usleep(50000); // 50ms
-        XTestFakeKeyEvent(display, keycode, False, 0);
-        XFlush(display);
-        XCloseDisplay(display);
-    }
-}
-#endif
@@ -0,0 +1,342 @@
+#include "Config.h"
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace {
+
+// 要素のパス（"BlinkDetection/EARThreshold" など）からテキストへの対応
+using ValueMap = std::map<std::string, std::string>;
+
+// 要素・テキスト・コメント・XML 宣言だけを扱う再帰下降パーサ（属性は読み飛ばす）
+class XmlReader {
+private:
+    const std::string& text;
+    size_t pos;
+    std::string error_message;
+
+public:
+    explicit XmlReader(const std::string& xml) : text(xml), pos(0) {}
+    
+    bool parseDocument(const std::string& root_name, ValueMap& values) {
+        skipMisc();
+        std::string name;
+        if (!parseElement("", 0, values, name)) {
+            return false;
+        }
+        if (name != root_name) {
+            return fail("root element must be <" + root_name + ">, found <" + name + ">");
+        }
+        skipMisc();
+        if (pos != text.size()) {
+            return fail("unexpected content after root element");
+        }
+        return true;
+    }
+    
+    const std::string& error() const { return error_message; }
+
+private:
+    bool fail(const std::string& message) {
+        int line = 1;
+        for (size_t i = 0; i < pos && i < text.size(); i++) {
+            if (text[i] == '\n') {
+                line++;
+            }
+        }
+        error_message = "line " + std::to_string(line) + ": " + message;
+        return false;
+    }
+    
+    bool startsWith(const char* token) const {
+        return text.compare(pos, std::char_traits<char>::length(token), token) == 0;
+    }
+    
+    void skipSpace() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+            pos++;
+        }
+    }
+    
+    // 空白・コメント・<?...?> を読み飛ばす
+    bool skipMisc() {
+        while (true) {
+            skipSpace();
+            const char* close = nullptr;
+            if (startsWith("<!--")) {
+                close = "-->";
+            } else if (startsWith("<?")) {
+                close = "?>";
+            } else {
+                return true;
+            }
+            size_t end = text.find(close, pos);
+            if (end == std::string::npos) {
+                return fail("unterminated comment or declaration");
+            }
+            pos = end + std::char_traits<char>::length(close);
+        }
+    }
+    
+    bool parseName(std::string& name) {
+        size_t start = pos;
+        while (pos < text.size() && (std::isalnum(static_cast<unsigned char>(text[pos])) ||
+                                     text[pos] == '_' || text[pos] == '-' || text[pos] == '.' || text[pos] == ':')) {
+            pos++;
+        }
+        if (pos == start) {
+            return fail("expected element name");
+        }
+        name = text.substr(start, pos - start);
+        return true;
+    }
+    
+    // ルート要素（depth 0）の名前はパスに含めない
+    bool parseElement(const std::string& parent_path, int depth, ValueMap& values, std::string& name) {
+        if (pos >= text.size() || text[pos] != '<') {
+            return fail("expected '<'");
+        }
+        pos++;
+        if (!parseName(name)) {
+            return false;
+        }
+        
+        // 属性は使わないので '>' まで飛ばす
+        size_t tag_end = text.find('>', pos);
+        if (tag_end == std::string::npos) {
+            return fail("unterminated tag <" + name + ">");
+        }
+        bool self_closing = tag_end > pos && text[tag_end - 1] == '/';
+        pos = tag_end + 1;
+        
+        std::string path = depth == 0 ? "" : parent_path.empty() ? name : parent_path + "/" + name;
+        if (self_closing) {
+            values[path] = "";
+            return true;
+        }
+        
+        std::string content;
+        bool has_children = false;
+        while (true) {
+            if (!skipMisc()) {
+                return false;
+            }
+            if (pos >= text.size()) {
+                return fail("missing </" + name + ">");
+            }
+            if (startsWith("</")) {
+                pos += 2;
+                std::string close_name;
+                if (!parseName(close_name)) {
+                    return false;
+                }
+                if (close_name != name) {
+                    return fail("expected </" + name + ">, found </" + close_name + ">");
+                }
+                skipSpace();
+                if (pos >= text.size() || text[pos] != '>') {
+                    return fail("expected '>'");
+                }
+                pos++;
+                break;
+            }
+            if (text[pos] == '<') {
+                std::string child_name;
+                if (!parseElement(path, depth + 1, values, child_name)) {
+                    return false;
+                }
+                has_children = true;
+                continue;
+            }
+            size_t text_end = text.find('<', pos);
+            if (text_end == std::string::npos) {
+                return fail("missing </" + name + ">");
+            }
+            content += text.substr(pos, text_end - pos);
+            pos = text_end;
+        }
+        
+        if (!has_children && depth > 0) {
+            // 前後の空白を除く
+            size_t first = content.find_first_not_of(" \t\r\n");
+            size_t last = content.find_last_not_of(" \t\r\n");
+            values[path] = first == std::string::npos ? "" : content.substr(first, last - first + 1);
+        }
+        return true;
+    }
+};
+
+// 型付きで値を取り出す。要素がなければ既定値のまま true
+class TypedValues {
+private:
+    ValueMap values;
+    std::string error_message;
+
+public:
+    explicit TypedValues(ValueMap map) : values(std::move(map)) {}
+    
+    bool getDouble(const std::string& key, double min_value, double max_value, double& out) {
+        auto it = values.find(key);
+        if (it == values.end()) {
+            return true;
+        }
+        const std::string text = it->second;
+        values.erase(it);
+        
+        char* end = nullptr;
+        double value = std::strtod(text.c_str(), &end);
+        if (text.empty() || *end != '\0' || value < min_value || value > max_value) {
+            std::ostringstream range;
+            range << "a number in [" << min_value << ", " << max_value << "]";
+            return fail(key, text, range.str());
+        }
+        out = value;
+        return true;
+    }
+    
+    bool getInt(const std::string& key, int min_value, int max_value, int& out) {
+        auto it = values.find(key);
+        if (it == values.end()) {
+            return true;
+        }
+        const std::string text = it->second;
+        values.erase(it);
+        
+        char* end = nullptr;
+        long value = std::strtol(text.c_str(), &end, 10);
+        if (text.empty() || *end != '\0' || value < min_value || value > max_value) {
+            return fail(key, text, "an integer in [" + std::to_string(min_value) + ", " + std::to_string(max_value) + "]");
+        }
+        out = static_cast<int>(value);
+        return true;
+    }
+    
+    template <typename Enum, size_t N>
+    bool getEnum(const std::string& key, const std::pair<const char*, Enum> (&choices)[N], Enum& out) {
+        auto it = values.find(key);
+        if (it == values.end()) {
+            return true;
+        }
+        const std::string text = it->second;
+        values.erase(it);
+        
+        std::string names;
+        for (const auto& choice : choices) {
+            if (text == choice.first) {
+                out = choice.second;
+                return true;
+            }
+            names += names.empty() ? choice.first : std::string("|") + choice.first;
+        }
+        return fail(key, text, names);
+    }
+    
+    // 読まなくなった要素を取り除く。あれば true
+    bool discard(const std::string& key) {
+        return values.erase(key) > 0;
+    }
+    
+    // 取り出されなかった要素（綴り間違いなど）
+    std::vector<std::string> unusedKeys() const {
+        std::vector<std::string> keys;
+        for (const auto& entry : values) {
+            keys.push_back(entry.first);
+        }
+        return keys;
+    }
+    
+    const std::string& error() const { return error_message; }
+
+private:
+    bool fail(const std::string& key, const std::string& text, const std::string& expected) {
+        error_message = key + ": '" + text + "' is not " + expected;
+        return false;
+    }
+};
+
+const std::pair<const char*, OpennessMetric> OPENNESS_METRICS[] = {
+    {"ContourEAR", OpennessMetric::ContourEAR},
+    {"ProjectionProfile", OpennessMetric::ProjectionProfile},
+};
+
+const std::pair<const char*, CapturePolicy> CAPTURE_POLICIES[] = {
+    {"LatestOnly", CapturePolicy::LatestOnly},
+    {"BoundedQueue", CapturePolicy::BoundedQueue},
+    {"Deadline", CapturePolicy::Deadline},
+};
+
+const std::pair<const char*, PupilLocatorMethod> PUPIL_LOCATORS[] = {
+    {"HoughCircles", PupilLocatorMethod::HoughCircles},
+    {"Gradient", PupilLocatorMethod::Gradient},
+};
+
+}
+
+bool ConfigLoader::parse(const std::string& xml, EyeTrackingConfig& config,
+                         std::string& error, std::vector<std::string>* warnings) {
+    ValueMap map;
+    XmlReader reader(xml);
+    if (!reader.parseDocument("EyeTrackingConfig", map)) {
+        error = reader.error();
+        return false;
+    }
+    
+    // 途中で失敗しても呼び出し側の設定を壊さないよう、コピーに読み込む
+    EyeTrackingConfig parsed = config;
+    TypedValues values(std::move(map));
+    
+    bool ok =
+        values.getDouble("BlinkDetection/EARThreshold", 0.0, 1.0, parsed.blink.ear_threshold) &&
+        values.getInt("BlinkDetection/ConsecutiveFrames", 1, 60, parsed.blink.consecutive_frames) &&
+        values.getInt("BlinkDetection/MaxBlinkInterval", 1, 10000, parsed.blink.max_blink_interval_ms) &&
+        values.getInt("BlinkDetection/LongBlinkDuration", 1, 10000, parsed.blink.long_blink_ms) &&
+        values.getEnum("BlinkDetection/OpennessMetric", OPENNESS_METRICS, parsed.blink.openness_metric) &&
+        values.getDouble("GazeTracking/DeadZoneRadius", 0.0, 10.0, parsed.gaze.dead_zone_radius) &&
+        values.getDouble("GazeTracking/MinMovementThreshold", 0.0, 10.0, parsed.gaze.min_movement_threshold) &&
+        values.getInt("GazeTracking/CommandTimeout", 0, 3600000, parsed.gaze.command_timeout_ms) &&
+        values.getEnum("GazeTracking/PupilLocator", PUPIL_LOCATORS, parsed.gaze.pupil_locator) &&
+        values.getInt("GazeTracking/PyramidLevels", 0, MatArena::MAX_PYRAMID_LEVELS, parsed.gaze.pyramid_levels) &&
+        values.getInt("Camera/Width", 1, 16384, parsed.camera.width) &&
+        values.getInt("Camera/Height", 1, 16384, parsed.camera.height) &&
+        values.getInt("Camera/FPS", 1, 1000, parsed.camera.fps) &&
+        values.getEnum("Camera/CapturePolicy", CAPTURE_POLICIES, parsed.camera.capture_policy) &&
+        values.getInt("Camera/MaxFrameAge", 1, 10000, parsed.camera.max_frame_age_ms);
+    if (!ok) {
+        error = values.error();
+        return false;
+    }
+    
+    // ダブル瞬きは2回目の閉じが確定した時点で判定するようになり、瞬きの最小間隔は使わない
+    bool has_min_blink_interval = values.discard("BlinkDetection/MinBlinkInterval");
+    
+    if (warnings) {
+        if (has_min_blink_interval) {
+            warnings->push_back("BlinkDetection/MinBlinkInterval is no longer used and is ignored");
+        }
+        for (const auto& key : values.unusedKeys()) {
+            warnings->push_back("unknown setting ignored: " + key);
+        }
+    }
+    
+    config = parsed;
+    return true;
+}
+
+bool ConfigLoader::load(const std::string& path, EyeTrackingConfig& config,
+                        std::string& error, std::vector<std::string>* warnings) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        error = "cannot open " + path;
+        return false;
+    }
+    
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    if (!parse(contents.str(), config, error, warnings)) {
+        error = path + ": " + error;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,155 @@
+#include "ConfigWatcher.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// inotify を待つ間も停止要求を見られるよう、この間隔で poll から戻る
+const int INOTIFY_POLL_TIMEOUT_MS = 200;
+// inotify が使えない場合の更新時刻の確認間隔
+const std::chrono::milliseconds POLL_INTERVAL(1000);
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return std::string();
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+}
+
+ConfigWatcher::ConfigWatcher(const std::string& config_path, const EyeTrackingConfig& initial)
+    : path(config_path), current(std::make_shared<const EyeTrackingConfig>(initial)),
+      config_generation(0), last_contents(readFile(config_path)), running(false) {
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    stop();
+}
+
+void ConfigWatcher::start() {
+    if (running) {
+        return;
+    }
+    running = true;
+    worker = std::thread(&ConfigWatcher::watchLoop, this);
+}
+
+void ConfigWatcher::stop() {
+    if (!worker.joinable()) {
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        running = false;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void ConfigWatcher::watchLoop() {
+    if (!watchWithInotify()) {
+        watchWithPolling();
+    }
+}
+
+bool ConfigWatcher::watchWithInotify() {
+#ifdef __linux__
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    
+    std::filesystem::path file_path(path);
+    std::filesystem::path directory = file_path.has_parent_path() ? file_path.parent_path() : std::filesystem::path(".");
+    std::string file_name = file_path.filename().string();
+    // 保存時に別名で書いてから置き換えるエディタもあるため、ファイルではなくディレクトリを監視する
+    int wd = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (wd < 0) {
+        close(fd);
+        return false;
+    }
+    
+    alignas(struct inotify_event) char buffer[4096];
+    while (running) {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, INOTIFY_POLL_TIMEOUT_MS) <= 0) {
+            continue;
+        }
+        
+        bool changed = false;
+        ssize_t length;
+        while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + length; ) {
+                const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+                if (event->len > 0 && file_name == event->name) {
+                    changed = true;
+                }
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+        if (changed) {
+            reload();
+        }
+    }
+    
+    inotify_rm_watch(fd, wd);
+    close(fd);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ConfigWatcher::watchWithPolling() {
+    std::error_code ec;
+    auto last_write = std::filesystem::last_write_time(path, ec);
+    
+    std::unique_lock<std::mutex> lock(wake_mutex);
+    while (!wake.wait_for(lock, POLL_INTERVAL, [this] { return !running; })) {
+        auto write_time = std::filesystem::last_write_time(path, ec);
+        if (!ec && write_time != last_write) {
+            last_write = write_time;
+            reload();
+        }
+    }
+}
+
+void ConfigWatcher::reload() {
+    std::string contents = readFile(path);
+    // 同じ内容の書き直し（タイムスタンプだけの更新など）は無視する
+    if (contents.empty() || contents == last_contents) {
+        return;
+    }
+    
+    // ファイルにない項目は既定値に戻す（ファイルの内容だけが設定になる）
+    EyeTrackingConfig config;
+    std::string error;
+    std::vector<std::string> warnings;
+    if (!ConfigLoader::parse(contents, config, error, &warnings)) {
+        // 書きかけのファイルを読んだ場合もここに来る。書き終わりのイベントでもう一度読む
+        std::cerr << "Config reload rejected (" << path << "): " << error << std::endl;
+        return;
+    }
+    for (const auto& warning : warnings) {
+        std::cerr << "Config: " << warning << std::endl;
+    }
+    
+    last_contents = contents;
+    std::atomic_store(&current, std::shared_ptr<const EyeTrackingConfig>(std::make_shared<EyeTrackingConfig>(config)));
+    config_generation.fetch_add(1, std::memory_order_release);
+    std::cout << "Config reloaded from: " << path << std::endl;
+}
@@ -1,97 +1,719 @@
 #include "EyeTracker.h"
 #include "Utils.h"
+#include <algorithm>
+#include <ctime>
 #include <iostream>
 
-EyeTracker::EyeTracker() 
-    : is_running(false), command_mode_active(false) {
+namespace {
+
+// キューが空のときの待機（ロックフリーキューなのでポーリング）
+void waitForQueue() {
+    std::this_thread::sleep_for(std::chrono::microseconds(500));
+}
+
+// プロファイルの検出パラメータを設定に重ねる
+// 列挙値はファイルから読んだままなので、範囲外なら既定値にする
+void applyProfileParameters(const CalibrationRecord& record, EyeTrackingConfig& config) {
+    config.blink.ear_threshold = record.ear_threshold;
+    config.blink.consecutive_frames = record.consecutive_frames;
+    config.gaze.pyramid_levels = record.pyramid_levels;
+    
+    if (record.openness_metric >= static_cast<int32_t>(OpennessMetric::ContourEAR) &&
+        record.openness_metric <= static_cast<int32_t>(OpennessMetric::ProjectionProfile)) {
+        config.blink.openness_metric = static_cast<OpennessMetric>(record.openness_metric);
+    } else {
+        config.blink.openness_metric = BlinkConfig().openness_metric;
+    }
+    if (record.pupil_locator >= static_cast<int32_t>(PupilLocatorMethod::HoughCircles) &&
+        record.pupil_locator <= static_cast<int32_t>(PupilLocatorMethod::Gradient)) {
+        config.gaze.pupil_locator = static_cast<PupilLocatorMethod>(record.pupil_locator);
+    } else {
+        config.gaze.pupil_locator = GazeConfig().pupil_locator;
+    }
+}
+
+// 間引き表示中にキューを空けに行く間隔（描画の間もウィンドウのイベントはこの間隔で処理する）
+const int PREVIEW_POLL_MS = 10;
+// ヘッドレス実行で終了を確かめる間隔
+const std::chrono::milliseconds HEADLESS_POLL(50);
+
+}
+
+EyeTracker::EyeTracker()
+    : is_running(false), capture_finished(false), analysis_finished(false), stopped(false),
+      live_source(false), capture_policy(CapturePolicy::LatestOnly), max_frame_age(std::chrono::milliseconds(100)),
+      display_mode(DisplayMode::Window), preview_fps(10.0), command_mode_active(false), latency_test(false), applied_config_generation(0),
+      calibration_record(), calibration_dirty(false), profile_loaded(false), user_switch_pending(false),
+      calibration_request(0), refinement_request(-1),
+      capture_queue(QUEUE_CAPACITY), present_queue(QUEUE_CAPACITY) {
     blink_detector = std::make_unique<BlinkDetector>();
     gaze_estimator = std::make_unique<GazeEstimator>();
-    command_controller = std::make_unique<CommandController>();
+    gaze_estimator->setMetrics(&metrics);
+    // コマンド送信は run() で作る（enableLatencyTest() で差し替えるときに既定のバックエンドを開かないため）
 }
 
 EyeTracker::~EyeTracker() {
     stop();
 }
 
+void EyeTracker::applyConfig(const EyeTrackingConfig& new_config) {
+    // カメラ設定は開くときにだけ使う（開き直すと取得が止まるため、実行中は反映しない）
+    bool camera_changed = source && (new_config.camera.width != config.camera.width ||
+                                     new_config.camera.height != config.camera.height ||
+                                     new_config.camera.fps != config.camera.fps ||
+                                     new_config.camera.capture_policy != config.camera.capture_policy ||
+                                     new_config.camera.max_frame_age_ms != config.camera.max_frame_age_ms);
+    if (camera_changed) {
+        std::cout << "Camera settings take effect on restart" << std::endl;
+    }
+    
+    config = new_config;
+    blink_detector->configure(config.blink);
+    gaze_estimator->configure(config.gaze);
+    if (command_controller) {
+        command_controller->configure(config.gaze);
+    }
+}
+
+void EyeTracker::watchConfig(const std::string& config_path) {
+    if (config_watcher) {
+        config_watcher->stop();
+    }
+    config_watcher = std::make_unique<ConfigWatcher>(config_path, config);
+    applied_config_generation = config_watcher->generation();
+    config_watcher->start();
+}
+
+void EyeTracker::applyPendingConfig() {
+    // 変更がなければ atomic 変数を1つ読むだけ
+    uint64_t generation = config_watcher->generation();
+    if (generation == applied_config_generation) {
+        return;
+    }
+    applied_config_generation = generation;
+    
+    std::shared_ptr<const EyeTrackingConfig> snapshot = config_watcher->snapshot();
+    // 再読み込みはファイルの内容だけになるため、読み込んだプロファイルの検出パラメータを重ね直す
+    if (profile_loaded) {
+        EyeTrackingConfig profile_config = *snapshot;
+        applyProfileParameters(calibration_record, profile_config);
+        applyConfig(profile_config);
+    } else {
+        applyConfig(*snapshot);
+    }
+}
+
+bool EyeTracker::openCalibrationStore(const std::string& store_path, const std::string& user) {
+    auto start = std::chrono::steady_clock::now();
+    // 読めなくても保存先とユーザーは決めておき、新しい較正で上書きする
+    calibration_user = user;
+    if (!calibration_store.open(store_path)) {
+        return false;
+    }
+    
+    bool warm = applyCalibrationProfile(user);
+    auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+    if (warm) {
+        std::cout << "Calibration profile '" << user << "' loaded in " << elapsed.count() << " us" << std::endl;
+    } else {
+        std::cout << "No calibration profile for '" << user << "'; calibrating on first use" << std::endl;
+    }
+    return true;
+}
+
+void EyeTracker::switchUser(const std::string& user) {
+    if (!analysis_thread.joinable()) {
+        saveCalibration();
+        calibration_user = user;
+        applyCalibrationProfile(user);
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(user_switch_mutex);
+    pending_user = user;
+    user_switch_pending = true;
+}
+
+void EyeTracker::startGazeCalibration(int point_count) {
+    calibration_request = point_count == 5 ? 5 : 9;
+}
+
+void EyeTracker::refineGazeCalibrationPoint(size_t index) {
+    refinement_request = static_cast<int>(index);
+}
+
+void EyeTracker::updateGazeCalibration(const FrameAnalysis& analysis, const cv::Size& roi_size) {
+    GazeMapping& mapping = gaze_estimator->mapping();
+    
+    int point_count = calibration_request.exchange(0);
+    if (point_count > 0) {
+        calibration_session.begin(point_count);
+        std::cout << point_count << "-point calibration started" << std::endl;
+    }
+    int refine_index = refinement_request.exchange(-1);
+    if (refine_index >= 0 && !calibration_session.isActive()) {
+        if (static_cast<size_t>(refine_index) < mapping.calibrationPoints().size()) {
+            calibration_session.beginRefinement(refine_index, mapping.calibrationPoints()[refine_index].target);
+        }
+    }
+    
+    if (!calibration_session.isActive()) {
+        return;
+    }
+    
+    bool confirmed = analysis.pupil_found && analysis.pupil_track_state == PupilTrackState::Confirmed;
+    if (!calibration_session.addSample(analysis.pupil_center, confirmed)) {
+        return;
+    }
+    
+    bool fitted = calibration_session.isRefinement()
+        ? mapping.refinePoint(calibration_session.refinedIndex(), calibration_session.points()[0].pupil)
+        : mapping.fit(calibration_session.points(), roi_size);
+    if (!fitted) {
+        std::cout << "Calibration failed: points are degenerate, keeping the previous mapping" << std::endl;
+        return;
+    }
+    std::cout << "Gaze mapping calibrated with " << mapping.calibrationPoints().size()
+              << " points (" << mapping.termCount() << " terms)" << std::endl;
+    recordCalibration(preprocess_cache, analysis);
+}
+
+bool EyeTracker::applyCalibrationProfile(const std::string& user) {
+    const CalibrationRecord* record = calibration_store.find(user);
+    profile_loaded = record != nullptr;
+    if (!record) {
+        return false;
+    }
+    
+    // 検出パラメータは設定の該当項目だけを上書きする
+    EyeTrackingConfig profile_config = config;
+    applyProfileParameters(*record, profile_config);
+    applyConfig(profile_config);
+    
+    if (record->baseline_x >= 0 && record->baseline_y >= 0) {
+        gaze_estimator->calibrateBaseline(cv::Point2f(record->baseline_x, record->baseline_y),
+                                          cv::Size(record->roi_width, record->roi_height));
+    }
+    cv::Size roi_size(record->roi_width, record->roi_height);
+    if (record->point_count > 0) {
+        // 点から当て直す（係数は同じになるが、1点の測り直しができるように点も持たせる）
+        std::vector<GazeMapping::CalibrationPoint> points(record->point_count);
+        for (uint32_t i = 0; i < record->point_count; i++) {
+            points[i].pupil = cv::Point2f(record->point_pupil[i][0], record->point_pupil[i][1]);
+            points[i].target = cv::Point2f(record->point_target[i][0], record->point_target[i][1]);
+        }
+        gaze_estimator->mapping().fit(points, roi_size);
+    } else if (record->mapping_terms > 0) {
+        gaze_estimator->mapping().setModel(roi_size,
+                                           static_cast<int>(record->mapping_terms),
+                                           record->mapping_x, record->mapping_y);
+    }
+    calibration_record = *record;
+    calibration_dirty = false;
+    return true;
+}
+
+void EyeTracker::recordCalibration(PreprocessCache& cache, const FrameAnalysis& analysis) {
+    CalibrationRecord& record = calibration_record;
+    record = CalibrationRecord();
+    CalibrationStore::setUserName(record, calibration_user);
+    record.updated_at = static_cast<int64_t>(std::time(nullptr));
+    
+    record.baseline_x = gaze_estimator->hasBaseline() ? gaze_estimator->getBaseline().x : -1.0f;
+    record.baseline_y = gaze_estimator->hasBaseline() ? gaze_estimator->getBaseline().y : -1.0f;
+    record.roi_width = cache.gray().cols;
+    record.roi_height = cache.gray().rows;
+    
+    const GazeMapping& mapping = gaze_estimator->mapping();
+    record.mapping_terms = mapping.isReady() ? static_cast<uint32_t>(mapping.termCount()) : 0;
+    for (uint32_t i = 0; i < record.mapping_terms; i++) {
+        record.mapping_x[i] = static_cast<float>(mapping.coefficientX(i));
+        record.mapping_y[i] = static_cast<float>(mapping.coefficientY(i));
+    }
+    const auto& points = mapping.calibrationPoints();
+    record.point_count = mapping.isReady()
+        ? static_cast<uint32_t>(std::min(points.size(), CalibrationRecord::MAX_CALIBRATION_POINTS)) : 0;
+    for (uint32_t i = 0; i < record.point_count; i++) {
+        record.point_pupil[i][0] = points[i].pupil.x;
+        record.point_pupil[i][1] = points[i].pupil.y;
+        record.point_target[i][0] = points[i].target.x;
+        record.point_target[i][1] = points[i].target.y;
+    }
+    
+    record.ear_threshold = static_cast<float>(config.blink.ear_threshold);
+    record.consecutive_frames = config.blink.consecutive_frames;
+    record.openness_metric = static_cast<int32_t>(config.blink.openness_metric);
+    record.pupil_locator = static_cast<int32_t>(config.gaze.pupil_locator);
+    record.pyramid_levels = config.gaze.pyramid_levels;
+    
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(cache.gray(), mean, stddev);
+    record.mean_intensity = static_cast<float>(mean[0]);
+    record.intensity_stddev = static_cast<float>(stddev[0]);
+    record.open_ear = static_cast<float>(analysis.ear);
+    record.samples = mapping.isReady() ? static_cast<uint32_t>(mapping.calibrationPoints().size()) : 1;
+    
+    calibration_dirty = true;
+}
+
+void EyeTracker::saveCalibration() {
+    // 書き込むのは停止時とユーザー切り替え時だけ（毎フレームの処理には入れない）
+    if (!calibration_dirty || calibration_user.empty()) {
+        return;
+    }
+    if (calibration_store.put(calibration_record)) {
+        std::cout << "Calibration profile '" << calibration_user << "' saved" << std::endl;
+    }
+    calibration_dirty = false;
+}
+
 bool EyeTracker::initialize(int camera_id) {
-    cap.open(camera_id);
-    if (!cap.isOpened()) {
+    auto camera = std::make_unique<CameraSource>();
+    if (!camera->open(camera_id, config.camera.width, config.camera.height, config.camera.fps)) {
         std::cerr << "Failed to open camera " << camera_id << std::endl;
         return false;
     }
     
-    // カメラ設定
-    cap.set(cv::CAP_PROP_FRAME_WIDTH, 640);
-    cap.set(cv::CAP_PROP_FRAME_HEIGHT, 480);
-    cap.set(cv::CAP_PROP_FPS, 30);
+    return initialize(std::move(camera));
+}
+
+bool EyeTracker::initialize(const std::string& replay_path, ReplayPacing pacing) {
+    auto replay = std::make_unique<ReplaySource>();
+    if (!replay->open(replay_path, pacing)) {
+        return false;
+    }
+    
+    std::cout << "Replaying " << replay_path << " at " << replay->fps() << " fps"
+              << (pacing == ReplayPacing::Realtime ? "" : " (as fast as possible)")
+              << std::endl;
+    return initialize(std::move(replay));
+}
+
+bool EyeTracker::initialize(std::unique_ptr<FrameSource> frame_source) {
+    if (!frame_source || !frame_source->isOpened()) {
+        return false;
+    }
+    source = std::move(frame_source);
+    
+    // 実際の解像度でフレームバッファを事前確保する
+    frame_pool = std::make_unique<FramePool>(POOL_SIZE, source->frameSize());
+    pupil_tracker.reset();
+    
+    return true;
+}
+
+bool EyeTracker::enablePointerMode(std::unique_ptr<CursorBackend> backend) {
+    if (!backend) {
+        auto platform = std::make_unique<PlatformCursorBackend>();
+        if (!platform->isAvailable()) {
+            std::cerr << "Pointer mode is not available: screen size unknown" << std::endl;
+            return false;
+        }
+        backend = std::move(platform);
+    }
+    
+    gaze_cursor = std::make_unique<GazeCursor>(std::move(backend));
+    return true;
+}
+
+void EyeTracker::setDisplayMode(DisplayMode mode, double fps) {
+    if (is_running) {
+        return;
+    }
+    display_mode = mode;
+    preview_fps = fps > 0 ? fps : 10.0;
+}
+
+bool EyeTracker::enableLatencyTest() {
+    if (is_running) {
+        return false;
+    }
     
+    // 実際のキーは送らず、送信スレッドが押した時点の記録だけ取る
+    createCommandController(std::make_unique<RecordingKeyBackend>());
+    latency_test = true;
     return true;
 }
 
+void EyeTracker::createCommandController(std::unique_ptr<KeyBackend> key_backend) {
+    command_controller = std::make_unique<CommandController>(std::move(key_backend));
+    command_controller->configure(config.gaze);
+    command_controller->getKeyInjector().setMetrics(&metrics);
+}
+
 void EyeTracker::run() {
+    if (!source) {
+        return;
+    }
+    
+    if (gaze_cursor && !gaze_cursor->start()) {
+        gaze_cursor.reset();
+    }
+    // 差し替えられていなければプラットフォームの既定のバックエンドで送る
+    if (!command_controller) {
+        createCommandController(nullptr);
+    }
+    
+    // 取得の方針は実行中に変えない（設定の再読み込みは解析スレッドが config を書き換えるため、ここで写す）
+    live_source = source->isLive();
+    std::atomic_store(&latest_frame, FramePacketPtr());
+    capture_policy = config.camera.capture_policy;
+    max_frame_age = std::chrono::milliseconds(config.camera.max_frame_age_ms);
+    
     is_running = true;
+    capture_finished = false;
+    analysis_finished = false;
+    stopped = false;
+    
+    capture_thread = std::thread(&EyeTracker::captureLoop, this);
+    analysis_thread = std::thread(&EyeTracker::analysisLoop, this);
+    
+    // HighGUI は run() を呼んだスレッドで扱う
+    if (display_mode == DisplayMode::Headless) {
+        headlessLoop();
+    } else {
+        presentationLoop();
+    }
+    
+    stop();
+}
+
+void EyeTracker::stop() {
+    // 計測値の書き出しや較正の保存を2回行わない
+    if (stopped) {
+        return;
+    }
+    stopped = true;
+    
+    is_running = false;
+    if (capture_thread.joinable()) {
+        capture_thread.join();
+    }
+    if (analysis_thread.joinable()) {
+        analysis_thread.join();
+    }
+    // 解析スレッドが止まってから、新しい較正（多点キャリブレーションを含む）を保存する
+    saveCalibration();
+    if (config_watcher) {
+        config_watcher->stop();
+    }
+    if (gaze_cursor) {
+        gaze_cursor->stop();
+    }
+    if (source) {
+        source->release();
+    }
+    if (display_mode != DisplayMode::Headless) {
+        cv::destroyAllWindows();
+    }
+    writeMetrics();
+}
+
+void EyeTracker::setMetricsOutput(const std::string& path) {
+    metrics_path = path;
+}
+
+bool EyeTracker::writeMetrics() {
+    if (metrics_path.empty() || !metrics.isEnabled()) {
+        return false;
+    }
+    if (!metrics.writeFile(metrics_path)) {
+        std::cerr << "Failed to write metrics: " << metrics_path << std::endl;
+        return false;
+    }
+    std::cout << "Metrics written to " << metrics_path << std::endl;
+    return true;
+}
+
+PipelineOccupancy EyeTracker::getPipelineOccupancy() const {
+    PipelineOccupancy occupancy;
+    
+    occupancy.capture.processed = metrics.counterValue(MetricCounter::FramesCaptured);
+    occupancy.capture.dropped = metrics.counterValue(MetricCounter::CaptureDropped);
+    
+    occupancy.analysis.queued = capture_queue.size() + (std::atomic_load(&latest_frame) ? 1 : 0);
+    occupancy.analysis.capacity = capture_queue.capacity();
+    occupancy.analysis.processed = metrics.counterValue(MetricCounter::FramesAnalyzed);
+    occupancy.analysis.dropped = metrics.counterValue(MetricCounter::AnalysisDropped);
+    
+    occupancy.presentation.queued = present_queue.size();
+    occupancy.presentation.capacity = present_queue.capacity();
+    occupancy.presentation.processed = metrics.counterValue(MetricCounter::FramesPresented);
+    
+    return occupancy;
+}
+
+void EyeTracker::captureLoop() {
+    uint64_t sequence = 0;
+    const bool live = live_source;
     
     while (is_running) {
-        cap >> current_frame;
-        if (current_frame.empty()) {
-            std::cerr << "Failed to capture frame" << std::endl;
+        FramePacketPtr packet = frame_pool->acquire();
+        if (!packet) {
+            if (!live) {
+                // 記録済み入力は後段が空くまで待ち、フレームを落とさない
+                waitForQueue();
+                continue;
+            }
+            // 全バッファが使用中: デバイスからは読み捨てて遅延の蓄積を防ぐ
+            if (!source->skip()) {
+                std::cerr << "Failed to capture frame" << std::endl;
+                break;
+            }
+            metrics.increment(MetricCounter::CaptureDropped);
+            continue;
+        }
+        
+        // 同じサイズのバッファには上書きされるため、ここで確保は発生しない
+        bool captured;
+        {
+            ScopedStageTimer timer(&metrics, MetricStage::CaptureWait);
+            captured = source->read(packet->frame, packet->capture_time);
+        }
+        if (!captured) {
+            if (live) {
+                std::cerr << "Failed to capture frame" << std::endl;
+            }
             break;
         }
+        packet->sequence = sequence++;
+        packet->analysis.timestamp = packet->capture_time;
+        packet->analysis.capture_time = source->lastCaptureTime();
+        metrics.increment(MetricCounter::FramesCaptured);
+        
+        if (live && capture_policy == CapturePolicy::LatestOnly) {
+            // 解析がまだ取っていない前のフレームは置き換える（バッファはプールに戻る）
+            FramePacketPtr replaced = std::atomic_exchange(&latest_frame, std::move(packet));
+            if (replaced) {
+                metrics.increment(MetricCounter::CaptureDropped);
+            }
+        } else if (live) {
+            // 解析が追いつかない場合は新しいフレームの取得を優先して破棄
+            if (!capture_queue.tryPush(std::move(packet))) {
+                metrics.increment(MetricCounter::CaptureDropped);
+            }
+        } else {
+            while (is_running && !capture_queue.tryPush(packet)) {
+                waitForQueue();
+            }
+        }
+    }
+    
+    capture_finished = true;
+}
+
+void EyeTracker::analysisLoop() {
+    FramePacketPtr packet;
+    
+    while (is_running) {
+        if (!takeFrame(packet)) {
+            // 入力終端なら、キューに残ったフレームを処理し終えてから終了する
+            if (capture_finished && capture_queue.empty() && !std::atomic_load(&latest_frame)) {
+                break;
+            }
+            waitForQueue();
+            continue;
+        }
+        
+        // 撮影から時間の経ったフレームを数え、Deadline の方針では解析せずに捨てる
+        if (live_source && std::chrono::steady_clock::now() - packet->analysis.capture_time > max_frame_age) {
+            metrics.increment(MetricCounter::StaleFrames);
+            if (capture_policy == CapturePolicy::Deadline) {
+                metrics.increment(MetricCounter::DeadlineDropped);
+                packet.reset();
+                continue;
+            }
+        }
+        
+        // 設定の変更はフレームの合間にまとめて反映する（1フレームの中で値が混ざらない）
+        if (config_watcher) {
+            applyPendingConfig();
+        }
+        if (user_switch_pending.load(std::memory_order_acquire)) {
+            std::string user;
+            {
+                std::lock_guard<std::mutex> lock(user_switch_mutex);
+                user = pending_user;
+                user_switch_pending = false;
+            }
+            // 前のユーザーの新しい較正は切り替え前に残す（書き込みは切り替え時の1回だけ）
+            saveCalibration();
+            calibration_user = user;
+            applyCalibrationProfile(user);
+        }
+        processFrame(*packet);
+        metrics.increment(MetricCounter::FramesAnalyzed);
+        metrics.record(MetricStage::CaptureToAnalysis,
+                       std::chrono::steady_clock::now() - packet->analysis.capture_time);
+        
+        // ヘッドレスでは表示ステージに渡さず、バッファはすぐプールに戻る
+        if (display_mode != DisplayMode::Headless && !present_queue.tryPush(std::move(packet))) {
+            metrics.increment(MetricCounter::AnalysisDropped);
+        }
+        packet.reset();
+    }
+    
+    analysis_finished = true;
+}
+
+bool EyeTracker::takeFrame(FramePacketPtr& packet) {
+    if (live_source && capture_policy == CapturePolicy::LatestOnly) {
+        packet = std::atomic_exchange(&latest_frame, FramePacketPtr());
+        return packet != nullptr;
+    }
+    return capture_queue.tryPop(packet);
+}
+
+void EyeTracker::presentationLoop() {
+    using Clock = std::chrono::steady_clock;
+    bool decimate = display_mode == DisplayMode::Preview;
+    Clock::duration render_interval = decimate
+        ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / preview_fps))
+        : Clock::duration::zero();
+    Clock::time_point next_render = Clock::now();
+    FramePacketPtr packet;
+    FramePacketPtr latest; // 次に描画する解析結果
+    
+    while (is_running) {
+        if (decimate) {
+            // 溜まった解析結果は最新の1つだけ残し、残りは描画せずにプールへ返す
+            while (present_queue.tryPop(packet)) {
+                if (latest) {
+                    metrics.increment(MetricCounter::PreviewSkipped);
+                }
+                latest = std::move(packet);
+            }
+        } else if (present_queue.tryPop(packet)) {
+            latest = std::move(packet);
+        }
         
-        processFrame();
+        Clock::time_point now = Clock::now();
+        if (latest && now >= next_render) {
+            {
+                ScopedStageTimer timer(&metrics, MetricStage::Render);
+                presentFrame(*latest);
+            }
+            metrics.increment(MetricCounter::FramesPresented);
+            latest.reset();
+            next_render = now + render_interval;
+        } else if (!latest && analysis_finished && present_queue.empty()) {
+            break;
+        }
         
-        // ESCキーで終了
-        char key = cv::waitKey(1) & 0xFF;
+        // ESCキーで終了（ウィンドウのイベント処理も兼ねる）
+        // 間引き表示では次の描画まで（最長 PREVIEW_POLL_MS）ここで待つ
+        int wait_ms = 1;
+        if (decimate) {
+            auto until_render = std::chrono::duration_cast<std::chrono::milliseconds>(next_render - Clock::now()).count();
+            wait_ms = static_cast<int>(std::max<long long>(1, std::min<long long>(until_render, PREVIEW_POLL_MS)));
+        }
+        char key = cv::waitKey(wait_ms) & 0xFF;
         if (key == 27) { // ESC key
             break;
         }
+        if (key == 'c') {
+            startGazeCalibration(9);
+        }
+        if (key == 'm') {
+            writeMetrics();
+        }
     }
-    
-    stop();
 }
 
-void EyeTracker::stop() {
-    is_running = false;
-    if (cap.isOpened()) {
-        cap.release();
+void EyeTracker::headlessLoop() {
+    // 表示しないので、入力の終端か停止の要求（シグナルなど）まで待つだけ
+    while (is_running && !analysis_finished) {
+        std::this_thread::sleep_for(HEADLESS_POLL);
     }
-    cv::destroyAllWindows();
 }
 
-void EyeTracker::processFrame() {
+void EyeTracker::processFrame(FramePacket& packet) {
     // 目の付近映像のみなので、フレーム全体を目領域として処理
-    cv::Mat eye_roi = current_frame.clone();
+    // 解析中は表示ステージに渡していないため、フレームはコピーせず参照する
+    const cv::Mat& eye_roi = packet.frame;
+    FrameAnalysis& analysis = packet.analysis;
+    
+    // 瞳孔検出とEAR計算はここで1回だけ行い、前処理結果も共有する
+    preprocess_cache.reset(eye_roi);
+    // 瞳孔は前フレームからの追跡で求め、見失ったときだけ全体検出する
+    {
+        ScopedStageTimer timer(&metrics, MetricStage::PupilTrack);
+        analysis.pupil_center = pupil_tracker.track(preprocess_cache, analysis.timestamp, *gaze_estimator);
+    }
+    analysis.pupil_found = analysis.pupil_center.x >= 0 && analysis.pupil_center.y >= 0;
+    analysis.pupil_track_state = pupil_tracker.state();
+    analysis.pupil_window_confirmed = pupil_tracker.confirmedByWindow();
+    if (!analysis.pupil_found) {
+        metrics.increment(MetricCounter::PupilLost);
+    }
+    {
+        ScopedStageTimer timer(&metrics, MetricStage::Ear);
+        analysis.ear = blink_detector->calculateOpenness(preprocess_cache);
+    }
     
     // ダブル瞬き検出
-    if (blink_detector->detectBlink(eye_roi)) {
-        if (blink_detector->checkDoubleBlinkPattern()) {
-            handleDoubleBlinkDetected();
-        }
+    blink_detector->detectBlink(analysis);
+    if (analysis.double_blink) {
+        handleDoubleBlinkDetected(analysis);
+    } else if (analysis.gesture != BlinkGesture::None) {
+        std::cout << "Gesture detected: " << BlinkGestureRecognizer::gestureName(analysis.gesture) << std::endl;
     }
     
-    // コマンドモードがアクティブな場合、視線方向を検出
-    if (command_mode_active) {
-        if (!gaze_estimator->isCalibrated()) {
-            gaze_estimator->calibrateBaseline(eye_roi);
-        } else {
-            cv::Point2f gaze_direction = gaze_estimator->calculateGazeDirection(eye_roi);
-            handleGazeDirection(gaze_direction);
+    // 多点キャリブレーションの進行と、写像の参照表の作り直し（数行ずつ）
+    updateGazeCalibration(analysis, eye_roi.size());
+    gaze_estimator->mapping().advanceRebuild(MAPPING_ROWS_PER_FRAME);
+    analysis.calibrating = calibration_session.isActive();
+    if (analysis.calibrating) {
+        analysis.calibration_target = calibration_session.currentTarget();
+    }
+    
+    // コマンドモード・ポインタモード・遅延計測中で未キャリブレーションなら現在の瞳孔位置を基準にする
+    // （遅延計測は較正済みになってからコマンドモードに入るため、ここで較正しないとキーが1回も押されない）
+    if ((command_mode_active || gaze_cursor || latency_test) && !gaze_estimator->isCalibrated()) {
+        gaze_estimator->calibrateBaseline(analysis.pupil_center, eye_roi.size());
+        if (gaze_estimator->isCalibrated()) {
+            recordCalibration(preprocess_cache, analysis);
         }
     }
     
+    {
+        ScopedStageTimer timer(&metrics, MetricStage::Gaze);
+        analysis.gaze_direction = gaze_estimator->calculateGazeDirection(analysis.pupil_center);
+    }
+    
+    // ポインタモード: カメラのレートで目標位置だけ渡す（補間と送出は GazeCursor のスレッド）
+    // 瞳孔を見失ったフレームと瞬き中は目標を更新せず、カーソルをその場に留める
+    // デッドゾーンをかけると中央付近に届かない輪ができるため、閾値をかけない位置を渡す
+    if (gaze_cursor && analysis.pupil_found && analysis.pupil_track_state == PupilTrackState::Confirmed) {
+        gaze_cursor->update(gaze_estimator->calculateGazePosition(analysis.pupil_center));
+    }
+    
+    // 遅延計測モード: 瞬きを待たずにコマンドモードに入り、タイムアウトしても入れ直す
+    if (latency_test && !command_mode_active && gaze_estimator->isCalibrated()) {
+        command_controller->activateCommandMode(analysis.timestamp);
+        command_mode_active = true;
+    }
+    
+    // コマンドモードがアクティブな場合、視線方向をコマンドに変換
+    if (command_mode_active && gaze_estimator->isCalibrated()) {
+        handleGazeDirection(analysis);
+    }
+    
+    analysis.command_active = command_mode_active;
+}
+
+void EyeTracker::presentFrame(FramePacket& packet) {
     // デバッグ情報の描画
-    cv::Point2f pupil_pos = gaze_estimator->detectPupilCenter(eye_roi);
-    cv::Point2f gaze_dir = gaze_estimator->calculateGazeDirection(eye_roi);
-    Utils::drawDebugInfo(current_frame, pupil_pos, gaze_dir, command_mode_active);
+    Utils::drawDebugInfo(packet.frame, packet.analysis);
     
-    cv::imshow("Eye Tracking", current_frame);
+    cv::imshow("Eye Tracking", packet.frame);
 }
 
-void EyeTracker::handleDoubleBlinkDetected() {
+void EyeTracker::handleDoubleBlinkDetected(const FrameAnalysis& analysis) {
     std::cout << "Double blink detected!" << std::endl;
     
     if (!command_mode_active) {
-        command_controller->activateCommandMode();
+        command_controller->activateCommandMode(analysis.timestamp);
         command_mode_active = true;
         std::cout << "Command mode activated" << std::endl;
     } else {
@@ -101,15 +723,19 @@ void EyeTracker::handleDoubleBlinkDetected() {
     }
 }
 
-void EyeTracker::handleGazeDirection(cv::Point2f direction) {
+void EyeTracker::handleGazeDirection(const FrameAnalysis& analysis) {
     // 方向の大きさが閾値を超えた場合のみコマンドを実行
+    const cv::Point2f& direction = analysis.gaze_direction;
     double magnitude = sqrt(direction.x * direction.x + direction.y * direction.y);
     if (magnitude > 0.3) {
-        command_controller->executeDirectionCommand(direction);
+        ScopedStageTimer timer(&metrics, MetricStage::CommandDispatch);
+        if (command_controller->executeDirectionCommand(analysis)) {
+            metrics.increment(MetricCounter::CommandsSent);
+        }
     }
     
     // コマンドモードのタイムアウトチェック
-    if (!command_controller->isCommandModeActive()) {
+    if (!command_controller->isCommandModeActive(analysis.timestamp)) {
         command_mode_active = false;
     }
 }
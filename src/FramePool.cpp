@@ -0,0 +1,38 @@
+#include "FramePool.h"
+#include <atomic>
+
+FramePool::FramePool(size_t packet_count, const cv::Size& frame_size, int frame_type)
+    : next_index(0) {
+    packets.reserve(packet_count);
+    for (size_t i = 0; i < packet_count; i++) {
+        auto packet = std::make_shared<FramePacket>();
+        packet->frame.create(frame_size, frame_type);
+        packets.push_back(packet);
+    }
+}
+
+FramePacketPtr FramePool::acquire() {
+    for (size_t n = 0; n < packets.size(); n++) {
+        size_t index = (next_index + n) % packets.size();
+        if (packets[index].use_count() == 1) {
+            // 他スレッドが参照を手放す前の書き込みを確実に見えるようにする
+            std::atomic_thread_fence(std::memory_order_acquire);
+            next_index = (index + 1) % packets.size();
+            
+            FramePacketPtr packet = packets[index];
+            packet->analysis = FrameAnalysis();
+            return packet;
+        }
+    }
+    return nullptr;
+}
+
+size_t FramePool::available() const {
+    size_t count = 0;
+    for (const auto& packet : packets) {
+        if (packet.use_count() == 1) {
+            count++;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,73 @@
+#include "FrameSource.h"
+
+namespace {
+
+// ドライバの時刻として受け入れる、取得完了までの最大の遅れ（これより古い値は別の時計とみなす）
+const std::chrono::milliseconds MAX_DRIVER_DELAY(500);
+
+}
+
+bool CameraSource::open(int camera_id, int width, int height, double fps) {
+    cap.open(camera_id);
+    if (!cap.isOpened()) {
+        return false;
+    }
+    
+    // カメラ設定
+    cap.set(cv::CAP_PROP_FRAME_WIDTH, width);
+    cap.set(cv::CAP_PROP_FRAME_HEIGHT, height);
+    cap.set(cv::CAP_PROP_FPS, fps);
+    // ドライバ側には溜めない（滞留はパイプラインのキューで扱う。対応しないバックエンドでは無視される）
+    cap.set(cv::CAP_PROP_BUFFERSIZE, 1);
+    
+    return true;
+}
+
+void CameraSource::release() {
+    if (cap.isOpened()) {
+        cap.release();
+    }
+}
+
+bool CameraSource::read(cv::Mat& frame, Clock::time_point& timestamp) {
+    // 展開（retrieve）の前に時刻を取り、デコードの時間を撮影時刻に含めない
+    if (!cap.grab()) {
+        return false;
+    }
+    Clock::time_point grabbed = Clock::now();
+    if (!cap.retrieve(frame) || frame.empty()) {
+        return false;
+    }
+    last_capture_time = driverTimestamp(grabbed);
+    timestamp = last_capture_time;
+    return true;
+}
+
+CameraSource::Clock::time_point CameraSource::driverTimestamp(Clock::time_point grabbed) {
+    // V4L2 では CAP_PROP_POS_MSEC がバッファの時刻（CLOCK_MONOTONIC = steady_clock）を返す
+    // 他のバックエンドは別の時計や再生位置を返すため、取得直後の時刻と矛盾しない値だけ使う
+    double pos_msec = cap.get(cv::CAP_PROP_POS_MSEC);
+    if (pos_msec > 0) {
+        Clock::time_point driver_time(std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::milli>(pos_msec)));
+        if (driver_time <= grabbed && grabbed - driver_time < MAX_DRIVER_DELAY) {
+            driver_timestamps = true;
+            return driver_time;
+        }
+    }
+    driver_timestamps = false;
+    return grabbed;
+}
+
+bool CameraSource::skip() {
+    return cap.grab();
+}
+
+cv::Size CameraSource::frameSize() const {
+    return cv::Size(static_cast<int>(cap.get(cv::CAP_PROP_FRAME_WIDTH)),
+                    static_cast<int>(cap.get(cv::CAP_PROP_FRAME_HEIGHT)));
+}
+
+double CameraSource::fps() const {
+    return cap.get(cv::CAP_PROP_FPS);
+}
@@ -0,0 +1,95 @@
+#include "GazeCalibration.h"
+#include <algorithm>
+
+namespace {
+
+float median(std::vector<float>& values) {
+    auto middle = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), middle, values.end());
+    return *middle;
+}
+
+}
+
+GazeCalibrationSession::GazeCalibrationSession()
+    : current(0), frames_on_target(0), active(false), refinement(false), refined_index(0) {
+    samples_x.reserve(SAMPLE_FRAMES);
+    samples_y.reserve(SAMPLE_FRAMES);
+}
+
+std::vector<cv::Point2f> GazeCalibrationSession::pattern(int point_count) {
+    const float e = TARGET_EXTENT;
+    if (point_count == 5) {
+        return {cv::Point2f(0, 0), cv::Point2f(-e, -e), cv::Point2f(e, -e),
+                cv::Point2f(-e, e), cv::Point2f(e, e)};
+    }
+    
+    // 9点: 左上から行ごと
+    std::vector<cv::Point2f> grid;
+    for (int row = -1; row <= 1; row++) {
+        for (int col = -1; col <= 1; col++) {
+            grid.push_back(cv::Point2f(col * e, row * e));
+        }
+    }
+    return grid;
+}
+
+void GazeCalibrationSession::begin(int point_count) {
+    restart(pattern(point_count));
+    refinement = false;
+}
+
+void GazeCalibrationSession::beginRefinement(size_t index, cv::Point2f target) {
+    restart(std::vector<cv::Point2f>(1, target));
+    refinement = true;
+    refined_index = index;
+}
+
+void GazeCalibrationSession::restart(std::vector<cv::Point2f> new_targets) {
+    targets = std::move(new_targets);
+    results.clear();
+    current = 0;
+    frames_on_target = 0;
+    samples_x.clear();
+    samples_y.clear();
+    active = true;
+}
+
+void GazeCalibrationSession::cancel() {
+    active = false;
+}
+
+bool GazeCalibrationSession::addSample(cv::Point2f pupil, bool pupil_found) {
+    if (!active) {
+        return false;
+    }
+    
+    frames_on_target++;
+    if (frames_on_target <= SETTLE_FRAMES || !pupil_found) {
+        return false;
+    }
+    
+    samples_x.push_back(pupil.x);
+    samples_y.push_back(pupil.y);
+    if (samples_x.size() < static_cast<size_t>(SAMPLE_FRAMES)) {
+        return false;
+    }
+    
+    // 瞬きや検出の外れ値に引きずられないよう中央値を使う
+    GazeMapping::CalibrationPoint point;
+    point.pupil = cv::Point2f(median(samples_x), median(samples_y));
+    point.target = targets[current];
+    results.push_back(point);
+    
+    samples_x.clear();
+    samples_y.clear();
+    frames_on_target = 0;
+    current++;
+    if (current < targets.size()) {
+        return false;
+    }
+    
+    current = targets.size() - 1;
+    active = false;
+    return true;
+}
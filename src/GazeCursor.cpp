@@ -0,0 +1,162 @@
+#include "GazeCursor.h"
+#include "PlatformController.h"
+#include <algorithm>
+#include <cmath>
+
+PlatformCursorBackend::PlatformCursorBackend() {
+    int width = 0, height = 0;
+    if (PlatformController::getScreenSize(width, height)) {
+        screen = cv::Size(width, height);
+    }
+}
+
+void PlatformCursorBackend::move(int x, int y) {
+    PlatformController::moveMouse(x, y);
+}
+
+RecordingCursorBackend::RecordingCursorBackend(cv::Size screen_size) : screen(screen_size) {
+}
+
+void RecordingCursorBackend::move(int x, int y) {
+    std::lock_guard<std::mutex> lock(moves_mutex);
+    recorded.push_back({cv::Point(x, y), std::chrono::steady_clock::now()});
+}
+
+std::vector<RecordedCursorMove> RecordingCursorBackend::moves() const {
+    std::lock_guard<std::mutex> lock(moves_mutex);
+    return recorded;
+}
+
+GazeCursor::GazeCursor(std::unique_ptr<CursorBackend> cursor_backend, double output_hz,
+                       double cursor_gain, double smoothing_time_ms)
+    : backend(std::move(cursor_backend)),
+      output_period(std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(1.0 / std::max(1.0, output_hz)))),
+      gain(cursor_gain), smoothing_ms(smoothing_time_ms),
+      sample_interval_ms(33.3), sample_count(0), last_sent(-1, -1),
+      running(false), update_count(0), tick_count(0), move_count(0) {
+    // 最初のサンプルが来るまでは画面中央
+    cv::Size screen = backend->screenSize();
+    smoothed = cv::Point2f(screen.width * 0.5f, screen.height * 0.5f);
+    previous_sample.target = smoothed;
+    latest_sample.target = smoothed;
+}
+
+GazeCursor::~GazeCursor() {
+    stop();
+}
+
+bool GazeCursor::start() {
+    if (running) {
+        return true;
+    }
+    if (backend->screenSize().area() <= 0) {
+        return false;
+    }
+    
+    running = true;
+    worker = std::thread(&GazeCursor::outputLoop, this);
+    return true;
+}
+
+void GazeCursor::stop() {
+    if (!worker.joinable()) {
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        running = false;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+cv::Point2f GazeCursor::mapToScreen(cv::Point2f gaze_direction) const {
+    cv::Size screen = backend->screenSize();
+    float half_width = screen.width * 0.5f;
+    float half_height = screen.height * 0.5f;
+    
+    float x = half_width + gaze_direction.x * static_cast<float>(gain) * half_width;
+    float y = half_height + gaze_direction.y * static_cast<float>(gain) * half_height;
+    x = std::max(0.0f, std::min(static_cast<float>(screen.width - 1), x));
+    y = std::max(0.0f, std::min(static_cast<float>(screen.height - 1), y));
+    return cv::Point2f(x, y);
+}
+
+void GazeCursor::update(cv::Point2f gaze_position) {
+    Clock::time_point now = Clock::now();
+    cv::Point2f target = mapToScreen(gaze_position);
+    
+    std::lock_guard<std::mutex> lock(sample_mutex);
+    if (sample_count > 0) {
+        // 補間の長さはカメラの実際の間隔に合わせる（極端な間隔は丸める）
+        double interval = std::chrono::duration<double, std::milli>(now - latest_sample.received).count();
+        interval = std::max(1.0, std::min(200.0, interval));
+        sample_interval_ms = sample_count == 1 ? interval : sample_interval_ms * 0.8 + interval * 0.2;
+    }
+    
+    // 補間途中から次の区間を始めると位置が飛ぶため、古い側には現在の補間位置を使う
+    double t = sample_count > 0
+        ? std::chrono::duration<double, std::milli>(now - latest_sample.received).count() / sample_interval_ms
+        : 1.0;
+    t = std::max(0.0, std::min(1.0, t));
+    previous_sample.target = previous_sample.target + (latest_sample.target - previous_sample.target) * static_cast<float>(t);
+    previous_sample.received = now;
+    latest_sample.target = target;
+    latest_sample.received = now;
+    sample_count++;
+    update_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void GazeCursor::outputLoop() {
+    Clock::time_point next_tick = Clock::now();
+    Clock::time_point last_tick = next_tick;
+    
+    while (true) {
+        Clock::time_point now = Clock::now();
+        double elapsed_ms = std::chrono::duration<double, std::milli>(now - last_tick).count();
+        last_tick = now;
+        tick(now, elapsed_ms);
+        
+        // 固定周期で刻む。遅れた場合は追いつこうとせず次の周期から再開する
+        next_tick += output_period;
+        if (next_tick <= now) {
+            next_tick = now + output_period;
+        }
+        
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        if (wake.wait_until(lock, next_tick, [this] { return !running; })) {
+            break;
+        }
+    }
+}
+
+void GazeCursor::tick(Clock::time_point now, double elapsed_ms) {
+    Sample from, to;
+    double interval_ms;
+    {
+        std::lock_guard<std::mutex> lock(sample_mutex);
+        from = previous_sample;
+        to = latest_sample;
+        interval_ms = sample_interval_ms;
+    }
+    
+    // 1. 直近2サンプルの間を、1サンプル間隔かけて線形補間する
+    double t = std::chrono::duration<double, std::milli>(now - to.received).count() / interval_ms;
+    t = std::max(0.0, std::min(1.0, t));
+    cv::Point2f interpolated = from.target + (to.target - from.target) * static_cast<float>(t);
+    
+    // 2. 指数平滑で視線の細かい揺れを抑える（出力レートに依らない時定数）
+    double alpha = smoothing_ms > 0.0 ? 1.0 - std::exp(-elapsed_ms / smoothing_ms) : 1.0;
+    smoothed += (interpolated - smoothed) * static_cast<float>(alpha);
+    tick_count.fetch_add(1, std::memory_order_relaxed);
+    
+    // 画素が変わらなければ送らない
+    cv::Point position(cvRound(smoothed.x), cvRound(smoothed.y));
+    if (position != last_sent) {
+        backend->move(position.x, position.y);
+        last_sent = position;
+        move_count.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -1,27 +1,70 @@
 #include "GazeEstimator.h"
+#include "Config.h"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 
+namespace {
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 最大半径の円を選ぶ
+bool largestCircle(const std::vector<cv::Vec3f>& circles, cv::Vec3f& largest) {
+    if (circles.empty()) {
+        return false;
+    }
+    largest = circles[0];
+    for (const auto& circle : circles) {
+        if (circle[2] > largest[2]) {
+            largest = circle;
+        }
+    }
+    return true;
+}
+
+}
+
 GazeEstimator::GazeEstimator(double threshold, double deadzone) 
-    : movement_threshold(threshold), deadzone_radius(deadzone), 
-      is_calibrated(false) {
+    : is_calibrated(false), movement_threshold(threshold), deadzone_radius(deadzone), 
+      locator_method(PupilLocatorMethod::HoughCircles),
+      pyramid_levels(0), metrics(nullptr) {
 }
 
 cv::Point2f GazeEstimator::calculateGazeDirection(const cv::Mat& eye_roi) {
-    if (!is_calibrated) {
+    if (!isCalibrated()) {
+        return cv::Point2f(0, 0);
+    }
+    
+    return calculateGazeDirection(detectPupilCenter(eye_roi));
+}
+
+cv::Point2f GazeEstimator::calculateGazePosition(const cv::Point2f& current_pupil) const {
+    if (!isCalibrated()) {
         return cv::Point2f(0, 0);
     }
     
-    cv::Point2f current_pupil = detectPupilCenter(eye_roi);
     if (current_pupil.x < 0 || current_pupil.y < 0) {
         return cv::Point2f(0, 0);
     }
     
-    // 正規化された相対位置を計算
     cv::Point2f relative_pos;
-    relative_pos.x = (current_pupil.x - baseline_pupil_pos.x) / (eye_roi_size.width * 0.5);
-    relative_pos.y = (current_pupil.y - baseline_pupil_pos.y) / (eye_roi_size.height * 0.5);
+    if (gaze_mapping.isReady()) {
+        // 多点キャリブレーション済みなら参照表を1回引くだけ（画面中央からの正規化座標）
+        relative_pos = gaze_mapping.lookup(current_pupil);
+    } else {
+        // 正規化された相対位置を計算
+        relative_pos.x = (current_pupil.x - baseline_pupil_pos.x) / (eye_roi_size.width * 0.5);
+        relative_pos.y = (current_pupil.y - baseline_pupil_pos.y) / (eye_roi_size.height * 0.5);
+    }
+    return relative_pos;
+}
+
+cv::Point2f GazeEstimator::calculateGazeDirection(const cv::Point2f& current_pupil) const {
+    cv::Point2f relative_pos = calculateGazePosition(current_pupil);
     
-    // デッドゾーンの適用
+    // デッドゾーンの適用（コマンドの誤発火を防ぐためのもの。連続的なポインタには使わない）
     double magnitude = sqrt(relative_pos.x * relative_pos.x + relative_pos.y * relative_pos.y);
     if (magnitude < deadzone_radius) {
         return cv::Point2f(0, 0);
@@ -36,18 +79,38 @@ cv::Point2f GazeEstimator::calculateGazeDirection(const cv::Mat& eye_roi) {
 }
 
 cv::Point2f GazeEstimator::detectPupilCenter(const cv::Mat& eye_roi) {
-    cv::Point2f pupil_center = findPupilUsingHoughCircles(eye_roi);
+    PreprocessCache cache(eye_roi);
+    return detectPupilCenter(cache);
+}
+
+cv::Point2f GazeEstimator::detectPupilCenter(PreprocessCache& cache) {
+    cv::Point2f pupil_center = locator_method == PupilLocatorMethod::Gradient
+        ? findPupilUsingGradient(cache)
+        : findPupilUsingHoughCircles(cache);
     
     if (pupil_center.x < 0 || pupil_center.y < 0) {
-        pupil_center = findPupilUsingContours(eye_roi);
+        if (metrics) {
+            metrics->increment(MetricCounter::HoughMiss);
+        }
+        {
+            ScopedStageTimer timer(metrics, MetricStage::ContourFallback);
+            pupil_center = findPupilUsingContours(cache);
+        }
+        if (metrics && (pupil_center.x < 0 || pupil_center.y < 0)) {
+            metrics->increment(MetricCounter::ContourMiss);
+        }
     }
     
     return pupil_center;
 }
 
 void GazeEstimator::calibrateBaseline(const cv::Mat& eye_roi) {
-    baseline_pupil_pos = detectPupilCenter(eye_roi);
-    eye_roi_size = eye_roi.size();
+    calibrateBaseline(detectPupilCenter(eye_roi), eye_roi.size());
+}
+
+void GazeEstimator::calibrateBaseline(const cv::Point2f& pupil_center, const cv::Size& roi_size) {
+    baseline_pupil_pos = pupil_center;
+    eye_roi_size = roi_size;
     
     if (baseline_pupil_pos.x >= 0 && baseline_pupil_pos.y >= 0) {
         is_calibrated = true;
@@ -55,48 +118,158 @@ void GazeEstimator::calibrateBaseline(const cv::Mat& eye_roi) {
     }
 }
 
-cv::Point2f GazeEstimator::findPupilUsingHoughCircles(const cv::Mat& eye_roi) {
-    cv::Mat processed = preprocessEyeImage(eye_roi);
+void GazeEstimator::configure(const GazeConfig& config) {
+    movement_threshold = config.min_movement_threshold;
+    deadzone_radius = config.dead_zone_radius;
+    locator_method = config.pupil_locator;
+    setPyramidLevels(config.pyramid_levels);
+}
+
+void GazeEstimator::setPyramidLevels(int levels) {
+    pyramid_levels = std::max(0, std::min(MatArena::MAX_PYRAMID_LEVELS, levels));
+}
+
+cv::Point2f GazeEstimator::findPupilUsingHoughCircles(PreprocessCache& cache) {
+    if (pyramid_levels > 0) {
+        return findPupilUsingPyramid(cache);
+    }
     
-    std::vector<cv::Vec3f> circles;
-    cv::HoughCircles(processed, circles, cv::HOUGH_GRADIENT, 1,
-                     processed.rows / 8, 100, 30, 
-                     processed.rows / 8, processed.rows / 3);
+    const cv::Mat* processed_ptr;
+    {
+        ScopedStageTimer timer(metrics, MetricStage::Preprocess);
+        processed_ptr = &preprocessEyeImage(cache);
+    }
+    const cv::Mat& processed = *processed_ptr;
     
-    if (!circles.empty()) {
-        cv::Vec3f largest_circle = circles[0];
-        for (const auto& circle : circles) {
-            if (circle[2] > largest_circle[2]) {
-                largest_circle = circle;
-            }
-        }
+    std::vector<cv::Vec3f>& circles = cache.arena().circles();
+    {
+        ScopedStageTimer timer(metrics, MetricStage::Hough);
+        cv::HoughCircles(processed, circles, cv::HOUGH_GRADIENT, 1,
+                         processed.rows / 8, 100, 30, 
+                         processed.rows / 8, processed.rows / 3);
+    }
+    
+    cv::Vec3f largest_circle;
+    if (largestCircle(circles, largest_circle)) {
         return cv::Point2f(largest_circle[0], largest_circle[1]);
     }
     
     return cv::Point2f(-1, -1);
 }
 
-cv::Point2f GazeEstimator::findPupilUsingContours(const cv::Mat& eye_roi) {
-    cv::Mat processed = preprocessEyeImage(eye_roi);
+cv::Point2f GazeEstimator::findPupilUsingPyramid(PreprocessCache& cache) {
+    MatArena& arena = cache.arena();
+    std::vector<cv::Vec3f>& circles = arena.circles();
+    const int scale = 1 << pyramid_levels;
+    pyramid_timing.levels = pyramid_levels;
+    pyramid_timing.level_ms.fill(0.0);
+    
+    // 1. 縮小画像を作り、最も粗い段でハフ変換する（pyrDown がぼかしも兼ねる）
+    // 縮小と二値化は原寸の経路と同じく前処理の段に、以降（原寸の小窓での処理を含む）はハフ変換の段に記録する
+    const cv::Mat* level_image;
+    cv::Mat coarse_binary;
+    std::chrono::steady_clock::time_point coarse_start;
+    {
+        ScopedStageTimer timer(metrics, MetricStage::Preprocess);
+        level_image = &cache.gray();
+        for (int level = 1; level <= pyramid_levels; level++) {
+            auto start = std::chrono::steady_clock::now();
+            cv::pyrDown(*level_image, arena.pyramid(level));
+            level_image = &arena.pyramid(level);
+            pyramid_timing.level_ms[level] += elapsedMs(start);
+        }
+        
+        coarse_start = std::chrono::steady_clock::now();
+        coarse_binary = arena.pyramidBinary()(cv::Rect(0, 0, level_image->cols, level_image->rows));
+        int coarse_block = std::max(3, (11 / scale) | 1);
+        cv::adaptiveThreshold(*level_image, coarse_binary, 255, cv::ADAPTIVE_THRESH_MEAN_C,
+                              cv::THRESH_BINARY, coarse_block, 2);
+    }
+    
+    ScopedStageTimer timer(metrics, MetricStage::Hough);
+    const cv::Mat& coarse = *level_image;
+    // 円周が短くなる分だけ投票数の閾値も下げる
+    cv::HoughCircles(coarse_binary, circles, cv::HOUGH_GRADIENT, 1,
+                     std::max(1, coarse.rows / 8), 100, std::max(10, 30 / scale),
+                     std::max(1, coarse.rows / 8), std::max(2, coarse.rows / 3));
+    cv::Vec3f coarse_circle;
+    bool coarse_found = largestCircle(circles, coarse_circle);
+    pyramid_timing.level_ms[pyramid_levels] += elapsedMs(coarse_start);
+    if (!coarse_found) {
+        return cv::Point2f(-1, -1);
+    }
+    
+    // 2. 原寸では粗い候補の周りの小窓だけで、半径を絞ってハフ変換する
+    auto refine_start = std::chrono::steady_clock::now();
+    const cv::Mat& gray = cache.gray();
+    cv::Point2f coarse_center(coarse_circle[0] * scale + (scale - 1) * 0.5f,
+                              coarse_circle[1] * scale + (scale - 1) * 0.5f);
+    int radius = cvRound(coarse_circle[2] * scale);
+    int tolerance = scale * 2;
+    int half_size = radius + tolerance + 2;
+    cv::Rect window = cv::Rect(cvRound(coarse_center.x) - half_size, cvRound(coarse_center.y) - half_size,
+                               half_size * 2 + 1, half_size * 2 + 1) &
+                      cv::Rect(0, 0, gray.cols, gray.rows);
+    
+    cv::Point2f refined = coarse_center;
+    if (window.width > 5 && window.height > 5) {
+        cv::Rect buffer_rect(0, 0, window.width, window.height);
+        cv::Mat blurred = arena.mat(MatArena::MAT_REFINE_BLURRED)(buffer_rect);
+        cv::Mat binary = arena.mat(MatArena::MAT_REFINE_BINARY)(buffer_rect);
+        cv::GaussianBlur(gray(window), blurred, cv::Size(5, 5), 0);
+        cv::adaptiveThreshold(blurred, binary, 255, cv::ADAPTIVE_THRESH_MEAN_C,
+                              cv::THRESH_BINARY, 11, 2);
+        cv::HoughCircles(binary, circles, cv::HOUGH_GRADIENT, 1,
+                         window.height, 100, 30,
+                         std::max(1, radius - tolerance), radius + tolerance);
+        
+        cv::Vec3f fine_circle;
+        if (largestCircle(circles, fine_circle)) {
+            refined = cv::Point2f(window.x + fine_circle[0], window.y + fine_circle[1]);
+        }
+    }
+    pyramid_timing.level_ms[0] += elapsedMs(refine_start);
+    
+    return refined;
+}
+
+cv::Point2f GazeEstimator::findPupilUsingGradient(PreprocessCache& cache) {
+    // 二値化前のブラー画像を使う（勾配の向きが必要なため）
+    const cv::Mat* blurred;
+    {
+        ScopedStageTimer timer(metrics, MetricStage::Preprocess);
+        blurred = &cache.blurred();
+    }
+    ScopedStageTimer timer(metrics, MetricStage::Hough);
+    return gradient_locator.locate(*blurred);
+}
+
+cv::Point2f GazeEstimator::findPupilUsingContours(PreprocessCache& cache) {
+    const cv::Mat& processed = preprocessEyeImage(cache);
     
-    // 反転して瞳孔を白にする
-    cv::Mat inverted;
+    // 反転して瞳孔を白にする（バッファはアリーナのものを再利用）
+    cv::Mat& inverted = cache.arena().mat(MatArena::MAT_INVERTED);
     cv::bitwise_not(processed, inverted);
     
-    std::vector<std::vector<cv::Point>> contours;
+    MatArena::Contours& contours = cache.arena().contours(MatArena::CONTOURS_PUPIL);
     cv::findContours(inverted, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
     
     if (contours.empty()) {
         return cv::Point2f(-1, -1);
     }
     
-    // 最大面積の輪郭を瞳孔として選択
-    auto max_contour = *std::max_element(contours.begin(), contours.end(),
-        [](const std::vector<cv::Point>& a, const std::vector<cv::Point>& b) {
-            return cv::contourArea(a) < cv::contourArea(b);
-        });
+    // 最大面積の輪郭を瞳孔として選択（コピーせずインデックスで参照）
+    size_t max_index = 0;
+    double max_area = -1.0;
+    for (size_t i = 0; i < contours.size(); i++) {
+        double area = cv::contourArea(contours[i]);
+        if (area > max_area) {
+            max_area = area;
+            max_index = i;
+        }
+    }
     
-    cv::Moments moments = cv::moments(max_contour);
+    cv::Moments moments = cv::moments(contours[max_index]);
     if (moments.m00 != 0) {
         cv::Point2f centroid(moments.m10 / moments.m00, moments.m01 / moments.m00);
         return centroid;
@@ -105,22 +278,7 @@ cv::Point2f GazeEstimator::findPupilUsingContours(const cv::Mat& eye_roi) {
     return cv::Point2f(-1, -1);
 }
 
-cv::Mat GazeEstimator::preprocessEyeImage(const cv::Mat& eye_roi) {
-    cv::Mat gray, processed;
-    
-    if (eye_roi.channels() == 3) {
-        cv::cvtColor(eye_roi, gray, cv::COLOR_BGR2GRAY);
-    } else {
-        gray = eye_roi.clone();
-    }
-    
-    // ガウシアンブラーでノイズ除去
-    cv::GaussianBlur(gray, processed, cv::Size(5, 5), 0);
-    
-    // 適応的閾値処理
-    cv::adaptiveThreshold(processed, processed, 255, 
-                         cv::ADAPTIVE_THRESH_MEAN_C, 
-                         cv::THRESH_BINARY, 11, 2);
-    
-    return processed;
+const cv::Mat& GazeEstimator::preprocessEyeImage(PreprocessCache& cache) {
+    // グレースケール化・ガウシアンブラー・適応的閾値処理はキャッシュ側で1回だけ行う
+    return cache.adaptiveBinary();
 }
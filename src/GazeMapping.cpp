@@ -0,0 +1,234 @@
+#include "GazeMapping.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 当てはめる項の数（点が足りないときは高次の項を落とす）
+// 5点（中央と四隅）では x^2 と y^2 の列が一致して解けないため 1, x, y, xy まで
+int termsForPoints(size_t point_count) {
+    if (point_count >= 9) {
+        return 6;
+    }
+    if (point_count >= 4) {
+        return 4;
+    }
+    return point_count >= 3 ? 3 : 0;
+}
+
+// 小さな正規方程式 A x = b をピボット選択付きのガウスの消去法で解く（A は n×n、行優先）
+bool solveLinear(double* a, double* b, int n) {
+    for (int col = 0; col < n; col++) {
+        int pivot = col;
+        for (int row = col + 1; row < n; row++) {
+            if (std::abs(a[row * n + col]) > std::abs(a[pivot * n + col])) {
+                pivot = row;
+            }
+        }
+        if (std::abs(a[pivot * n + col]) < 1e-12) {
+            return false;
+        }
+        if (pivot != col) {
+            for (int k = 0; k < n; k++) {
+                std::swap(a[col * n + k], a[pivot * n + k]);
+            }
+            std::swap(b[col], b[pivot]);
+        }
+        for (int row = 0; row < n; row++) {
+            if (row == col) {
+                continue;
+            }
+            double factor = a[row * n + col] / a[col * n + col];
+            for (int k = col; k < n; k++) {
+                a[row * n + k] -= factor * a[col * n + k];
+            }
+            b[row] -= factor * b[col];
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        b[i] /= a[i * n + i];
+    }
+    return true;
+}
+
+}
+
+GazeMapping::GazeMapping() : terms(0), pending_row(-1) {
+    coeff_x.fill(0.0);
+    coeff_y.fill(0.0);
+}
+
+bool GazeMapping::fit(const std::vector<CalibrationPoint>& calibration_points, cv::Size eye_roi_size) {
+    if (eye_roi_size.width <= 0 || eye_roi_size.height <= 0) {
+        return false;
+    }
+    
+    std::vector<CalibrationPoint> previous_points = points;
+    cv::Size previous_size = roi_size;
+    points = calibration_points;
+    roi_size = eye_roi_size;
+    if (!solve()) {
+        points = previous_points;
+        roi_size = previous_size;
+        return false;
+    }
+    
+    // 初回や目領域の大きさが変わった場合は、古い表が使えないので一度に作る
+    startRebuild();
+    if (!active.ready || active.cols != pending.cols || active.rows != pending.rows) {
+        advanceRebuild(pending.rows + 1);
+    }
+    return true;
+}
+
+bool GazeMapping::refinePoint(size_t index, cv::Point2f pupil) {
+    if (index >= points.size()) {
+        return false;
+    }
+    
+    cv::Point2f previous = points[index].pupil;
+    points[index].pupil = pupil;
+    if (!solve()) {
+        points[index].pupil = previous;
+        solve();
+        return false;
+    }
+    
+    // 作り直しの間は古い表で変換を続ける（1フレームで全体を作り直さない）
+    startRebuild();
+    return true;
+}
+
+bool GazeMapping::setModel(cv::Size eye_roi_size, int term_count,
+                           const float* x_coefficients, const float* y_coefficients) {
+    if (term_count < 3 || term_count > MAX_TERMS || eye_roi_size.width <= 0 || eye_roi_size.height <= 0) {
+        return false;
+    }
+    
+    roi_size = eye_roi_size;
+    terms = term_count;
+    coeff_x.fill(0.0);
+    coeff_y.fill(0.0);
+    for (int i = 0; i < term_count; i++) {
+        coeff_x[i] = x_coefficients[i];
+        coeff_y[i] = y_coefficients[i];
+    }
+    points.clear();
+    
+    startRebuild();
+    advanceRebuild(pending.rows + 1);
+    return true;
+}
+
+void GazeMapping::basis(double x, double y, double* out) const {
+    // 目領域の大きさで正規化し、中央を原点にする（正規方程式の条件数を抑える）
+    double nx = x / roi_size.width - 0.5;
+    double ny = y / roi_size.height - 0.5;
+    out[0] = 1.0;
+    out[1] = nx;
+    out[2] = ny;
+    out[3] = nx * ny;
+    out[4] = nx * nx;
+    out[5] = ny * ny;
+}
+
+bool GazeMapping::solve() {
+    int n = termsForPoints(points.size());
+    if (n == 0) {
+        return false;
+    }
+    
+    // 最小二乗の正規方程式（x と y で係数行列は共通）
+    double ata[MAX_TERMS * MAX_TERMS] = {};
+    double atb_x[MAX_TERMS] = {};
+    double atb_y[MAX_TERMS] = {};
+    for (const auto& point : points) {
+        double row[MAX_TERMS];
+        basis(point.pupil.x, point.pupil.y, row);
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                ata[i * n + j] += row[i] * row[j];
+            }
+            atb_x[i] += row[i] * point.target.x;
+            atb_y[i] += row[i] * point.target.y;
+        }
+    }
+    
+    double ata_copy[MAX_TERMS * MAX_TERMS];
+    std::copy(ata, ata + n * n, ata_copy);
+    if (!solveLinear(ata, atb_x, n) || !solveLinear(ata_copy, atb_y, n)) {
+        return false;
+    }
+    
+    terms = n;
+    coeff_x.fill(0.0);
+    coeff_y.fill(0.0);
+    std::copy(atb_x, atb_x + n, coeff_x.begin());
+    std::copy(atb_y, atb_y + n, coeff_y.begin());
+    return true;
+}
+
+cv::Point2f GazeMapping::evaluate(cv::Point2f pupil) const {
+    double row[MAX_TERMS];
+    basis(pupil.x, pupil.y, row);
+    double x = 0.0, y = 0.0;
+    for (int i = 0; i < terms; i++) {
+        x += coeff_x[i] * row[i];
+        y += coeff_y[i] * row[i];
+    }
+    return cv::Point2f(static_cast<float>(x), static_cast<float>(y));
+}
+
+void GazeMapping::startRebuild() {
+    int long_side = std::max(roi_size.width, roi_size.height);
+    pending.cell_size = std::max(1.0f, static_cast<float>(long_side) / GRID_CELLS);
+    pending.cols = static_cast<int>(std::ceil(roi_size.width / pending.cell_size));
+    pending.rows = static_cast<int>(std::ceil(roi_size.height / pending.cell_size));
+    pending.nodes.resize(static_cast<size_t>(pending.cols + 1) * (pending.rows + 1));
+    pending.ready = false;
+    pending_row = 0;
+}
+
+void GazeMapping::advanceRebuild(int max_rows) {
+    if (pending_row < 0) {
+        return;
+    }
+    
+    int last_row = std::min(pending.rows, pending_row + max_rows - 1);
+    buildRows(pending, pending_row, last_row);
+    pending_row = last_row + 1;
+    
+    if (pending_row > pending.rows) {
+        pending.ready = true;
+        std::swap(active, pending);
+        pending_row = -1;
+    }
+}
+
+void GazeMapping::buildRows(Table& table, int first_row, int last_row) const {
+    for (int row = first_row; row <= last_row; row++) {
+        cv::Point2f* nodes = &table.nodes[static_cast<size_t>(row) * (table.cols + 1)];
+        float y = row * table.cell_size;
+        for (int col = 0; col <= table.cols; col++) {
+            nodes[col] = evaluate(cv::Point2f(col * table.cell_size, y));
+        }
+    }
+}
+
+cv::Point2f GazeMapping::lookup(cv::Point2f pupil) const {
+    const Table& table = active;
+    
+    // 表の外は端の値を使う
+    float u = std::max(0.0f, std::min(static_cast<float>(table.cols), pupil.x / table.cell_size));
+    float v = std::max(0.0f, std::min(static_cast<float>(table.rows), pupil.y / table.cell_size));
+    int col = std::min(static_cast<int>(u), table.cols - 1);
+    int row = std::min(static_cast<int>(v), table.rows - 1);
+    float fx = u - col;
+    float fy = v - row;
+    
+    const cv::Point2f* top = &table.nodes[static_cast<size_t>(row) * (table.cols + 1) + col];
+    const cv::Point2f* bottom = top + (table.cols + 1);
+    cv::Point2f upper = top[0] + (top[1] - top[0]) * fx;
+    cv::Point2f lower = bottom[0] + (bottom[1] - bottom[0]) * fx;
+    return upper + (lower - upper) * fy;
+}
@@ -0,0 +1,363 @@
+#include "GradientPupilLocator.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define GRADIENT_LOCATOR_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(GRADIENT_LOCATOR_X86) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define GRADIENT_LOCATOR_SSE2 1
+#endif
+
+#if defined(GRADIENT_LOCATOR_X86) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#define GRADIENT_LOCATOR_AVX2 1
+#if defined(__GNUC__) || defined(__clang__)
+#define GRADIENT_LOCATOR_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define GRADIENT_LOCATOR_TARGET_AVX2
+#endif
+#endif
+
+namespace {
+
+// 勾配点が候補点と重なったときのゼロ除算避け
+const float MIN_DISTANCE_SQ = 1e-6f;
+// 勾配の大きさの閾値: 平均 + 係数 * 標準偏差
+const double GRADIENT_THRESHOLD_STDDEV = 0.3;
+
+// 各勾配点について max(0, d·g)^2 / |d|^2 の総和（d は正規化前の変位）
+double sumScalar(const float* xs, const float* ys, const float* gxs, const float* gys,
+                 size_t begin, size_t count, float cx, float cy) {
+    double acc = 0.0;
+    for (size_t i = begin; i < count; i++) {
+        float dx = xs[i] - cx;
+        float dy = ys[i] - cy;
+        float dot = dx * gxs[i] + dy * gys[i];
+        if (dot > 0) {
+            float length_sq = std::max(dx * dx + dy * dy, MIN_DISTANCE_SQ);
+            acc += dot * dot / length_sq;
+        }
+    }
+    return acc;
+}
+
+#if defined(GRADIENT_LOCATOR_SSE2)
+double sumSSE2(const float* xs, const float* ys, const float* gxs, const float* gys,
+               size_t count, float cx, float cy) {
+    const __m128 center_x = _mm_set1_ps(cx);
+    const __m128 center_y = _mm_set1_ps(cy);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 min_length = _mm_set1_ps(MIN_DISTANCE_SQ);
+    __m128 acc = _mm_setzero_ps();
+    
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i), center_x);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + i), center_y);
+        __m128 dot = _mm_add_ps(_mm_mul_ps(dx, _mm_loadu_ps(gxs + i)),
+                                _mm_mul_ps(dy, _mm_loadu_ps(gys + i)));
+        dot = _mm_max_ps(dot, zero);
+        __m128 length_sq = _mm_max_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), min_length);
+        acc = _mm_add_ps(acc, _mm_div_ps(_mm_mul_ps(dot, dot), length_sq));
+    }
+    
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, acc);
+    double total = static_cast<double>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+    return total + sumScalar(xs, ys, gxs, gys, i, count, cx, cy);
+}
+#endif
+
+#if defined(GRADIENT_LOCATOR_AVX2)
+GRADIENT_LOCATOR_TARGET_AVX2
+double sumAVX2(const float* xs, const float* ys, const float* gxs, const float* gys,
+               size_t count, float cx, float cy) {
+    const __m256 center_x = _mm256_set1_ps(cx);
+    const __m256 center_y = _mm256_set1_ps(cy);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 min_length = _mm256_set1_ps(MIN_DISTANCE_SQ);
+    __m256 acc = _mm256_setzero_ps();
+    
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs + i), center_x);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(ys + i), center_y);
+        __m256 dot = _mm256_fmadd_ps(dy, _mm256_loadu_ps(gys + i),
+                                     _mm256_mul_ps(dx, _mm256_loadu_ps(gxs + i)));
+        dot = _mm256_max_ps(dot, zero);
+        __m256 length_sq = _mm256_max_ps(_mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dx, dx)), min_length);
+        acc = _mm256_add_ps(acc, _mm256_div_ps(_mm256_mul_ps(dot, dot), length_sq));
+    }
+    
+    alignas(32) float lanes[8];
+    _mm256_store_ps(lanes, acc);
+    double total = 0.0;
+    for (float lane : lanes) {
+        total += lane;
+    }
+    return total + sumScalar(xs, ys, gxs, gys, i, count, cx, cy);
+}
+#endif
+
+bool cpuSupportsAVX2() {
+#if defined(GRADIENT_LOCATOR_AVX2)
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool os_saves_ymm = (info[2] & (1 << 27)) != 0;
+    bool has_fma = (info[2] & (1 << 12)) != 0;
+    if (!os_saves_ymm || !has_fma || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#endif
+#else
+    return false;
+#endif
+}
+
+// 二次関数の頂点のずれ（-0.5..0.5）
+float parabolicOffset(double left, double center, double right) {
+    double denominator = left - 2.0 * center + right;
+    if (denominator >= 0) {
+        return 0.0f;
+    }
+    double offset = 0.5 * (left - right) / denominator;
+    return static_cast<float>(std::max(-0.5, std::min(0.5, offset)));
+}
+
+}
+
+void GradientPupilLocator::GradientField::clear() {
+    x.clear();
+    y.clear();
+    gx.clear();
+    gy.clear();
+}
+
+GradientPupilLocator::GradientPupilLocator(int width, size_t max_points)
+    : coarse_width(std::max(8, width)), max_refine_points(std::max<size_t>(64, max_points)),
+      kernel(detectKernel()) {
+}
+
+const char* GradientPupilLocator::kernelName(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::AVX2: return "AVX2";
+        case Kernel::SSE2: return "SSE2";
+        default: return "scalar";
+    }
+}
+
+GradientPupilLocator::Kernel GradientPupilLocator::detectKernel() {
+    if (cpuSupportsAVX2()) {
+        return Kernel::AVX2;
+    }
+#if defined(GRADIENT_LOCATOR_SSE2)
+    return Kernel::SSE2;
+#else
+    return Kernel::Scalar;
+#endif
+}
+
+void GradientPupilLocator::forceKernel(Kernel forced) {
+    if (forced == Kernel::AVX2 && !cpuSupportsAVX2()) {
+        return;
+    }
+#if !defined(GRADIENT_LOCATOR_SSE2)
+    if (forced == Kernel::SSE2) {
+        return;
+    }
+#endif
+    kernel = forced;
+}
+
+void GradientPupilLocator::collectGradients(const cv::Mat& image, const cv::Rect& region,
+                                            int stride, GradientField& field) {
+    field.clear();
+    magnitude_buffer.clear();
+    
+    // 画像端は中心差分が取れないので除く
+    int x_begin = std::max(1, region.x);
+    int y_begin = std::max(1, region.y);
+    int x_end = std::min(image.cols - 1, region.x + region.width);
+    int y_end = std::min(image.rows - 1, region.y + region.height);
+    
+    double sum = 0.0;
+    double sum_sq = 0.0;
+    size_t sampled = 0;
+    
+    for (int y = y_begin; y < y_end; y += stride) {
+        const uchar* above = image.ptr<uchar>(y - 1);
+        const uchar* row = image.ptr<uchar>(y);
+        const uchar* below = image.ptr<uchar>(y + 1);
+        for (int x = x_begin; x < x_end; x += stride) {
+            float gx = 0.5f * (static_cast<float>(row[x + 1]) - row[x - 1]);
+            float gy = 0.5f * (static_cast<float>(below[x]) - above[x]);
+            float magnitude = std::sqrt(gx * gx + gy * gy);
+            sum += magnitude;
+            sum_sq += magnitude * magnitude;
+            sampled++;
+            if (magnitude > 0) {
+                field.x.push_back(static_cast<float>(x));
+                field.y.push_back(static_cast<float>(y));
+                field.gx.push_back(gx);
+                field.gy.push_back(gy);
+                magnitude_buffer.push_back(magnitude);
+            }
+        }
+    }
+    
+    if (sampled == 0) {
+        return;
+    }
+    
+    double mean = sum / sampled;
+    double stddev = std::sqrt(std::max(0.0, sum_sq / sampled - mean * mean));
+    float threshold = static_cast<float>(mean + GRADIENT_THRESHOLD_STDDEV * stddev);
+    
+    // 弱い勾配を除き、残りを単位ベクトルにする（その場で詰める）
+    size_t kept = 0;
+    for (size_t i = 0; i < field.size(); i++) {
+        float magnitude = magnitude_buffer[i];
+        if (magnitude < threshold) {
+            continue;
+        }
+        field.x[kept] = field.x[i];
+        field.y[kept] = field.y[i];
+        field.gx[kept] = field.gx[i] / magnitude;
+        field.gy[kept] = field.gy[i] / magnitude;
+        kept++;
+    }
+    field.x.resize(kept);
+    field.y.resize(kept);
+    field.gx.resize(kept);
+    field.gy.resize(kept);
+}
+
+double GradientPupilLocator::objective(const GradientField& field, float cx, float cy) const {
+    const size_t count = field.size();
+    switch (kernel) {
+#if defined(GRADIENT_LOCATOR_AVX2)
+        case Kernel::AVX2:
+            return sumAVX2(field.x.data(), field.y.data(), field.gx.data(), field.gy.data(),
+                           count, cx, cy);
+#endif
+#if defined(GRADIENT_LOCATOR_SSE2)
+        case Kernel::SSE2:
+            return sumSSE2(field.x.data(), field.y.data(), field.gx.data(), field.gy.data(),
+                           count, cx, cy);
+#endif
+        default:
+            return sumScalar(field.x.data(), field.y.data(), field.gx.data(), field.gy.data(),
+                             0, count, cx, cy);
+    }
+}
+
+double GradientPupilLocator::weightedObjective(const GradientField& field, const cv::Mat& image,
+                                               int x, int y) const {
+    // 瞳孔は暗いので、暗い候補点ほど重みを大きくする
+    double darkness = 255.0 - image.at<uchar>(y, x);
+    return darkness * objective(field, static_cast<float>(x), static_cast<float>(y));
+}
+
+cv::Point2f GradientPupilLocator::locate(const cv::Mat& gray) {
+    if (gray.empty() || gray.type() != CV_8UC1 || gray.cols < 3 || gray.rows < 3) {
+        return cv::Point2f(-1, -1);
+    }
+    
+    // 1. 縮小画像の全候補点で評価する
+    double scale = 1.0;
+    if (gray.cols > coarse_width) {
+        scale = static_cast<double>(gray.cols) / coarse_width;
+        int coarse_height = std::max(8, cvRound(gray.rows / scale));
+        cv::resize(gray, coarse_image, cv::Size(coarse_width, coarse_height), 0, 0, cv::INTER_AREA);
+    } else {
+        coarse_image = gray;
+    }
+    double scale_x = static_cast<double>(gray.cols) / coarse_image.cols;
+    double scale_y = static_cast<double>(gray.rows) / coarse_image.rows;
+    
+    collectGradients(coarse_image, cv::Rect(0, 0, coarse_image.cols, coarse_image.rows), 1, coarse_field);
+    if (coarse_field.size() == 0) {
+        return cv::Point2f(-1, -1);
+    }
+    
+    double best_score = 0.0;
+    cv::Point best(-1, -1);
+    for (int y = 1; y < coarse_image.rows - 1; y++) {
+        for (int x = 1; x < coarse_image.cols - 1; x++) {
+            double score = weightedObjective(coarse_field, coarse_image, x, y);
+            if (score > best_score) {
+                best_score = score;
+                best = cv::Point(x, y);
+            }
+        }
+    }
+    if (best.x < 0) {
+        return cv::Point2f(-1, -1);
+    }
+    
+    // 2. 原寸で、縮小時の候補点の周辺の勾配だけを使って山登りする
+    cv::Point current(std::min(gray.cols - 2, std::max(1, cvRound((best.x + 0.5) * scale_x - 0.5))),
+                      std::min(gray.rows - 2, std::max(1, cvRound((best.y + 0.5) * scale_y - 0.5))));
+    
+    int half_size = std::max(8, std::min(gray.rows, gray.cols) / 3);
+    cv::Rect region = cv::Rect(current.x - half_size, current.y - half_size,
+                               half_size * 2 + 1, half_size * 2 + 1) &
+                      cv::Rect(0, 0, gray.cols, gray.rows);
+    // 閾値処理で残るのは3割程度なので、その分だけ多めにサンプリングする
+    int stride = std::max(1, static_cast<int>(std::ceil(
+        std::sqrt(static_cast<double>(region.area()) / (max_refine_points * 3)))));
+    collectGradients(gray, region, stride, fine_field);
+    if (fine_field.size() == 0) {
+        return cv::Point2f(static_cast<float>(current.x), static_cast<float>(current.y));
+    }
+    
+    auto score_at = [&](int x, int y) {
+        if (x < 1 || y < 1 || x >= gray.cols - 1 || y >= gray.rows - 1) {
+            return 0.0;
+        }
+        return weightedObjective(fine_field, gray, x, y);
+    };
+    
+    double current_score = score_at(current.x, current.y);
+    int max_steps = static_cast<int>(std::ceil(std::max(scale_x, scale_y))) * 2 + 2;
+    for (int step = 0; step < max_steps; step++) {
+        cv::Point next = current;
+        double next_score = current_score;
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                if (dx == 0 && dy == 0) {
+                    continue;
+                }
+                double score = score_at(current.x + dx, current.y + dy);
+                if (score > next_score) {
+                    next_score = score;
+                    next = cv::Point(current.x + dx, current.y + dy);
+                }
+            }
+        }
+        if (next == current) {
+            break;
+        }
+        current = next;
+        current_score = next_score;
+    }
+    
+    // 3. 左右・上下の評価値からサブピクセル位置を求める
+    float offset_x = parabolicOffset(score_at(current.x - 1, current.y), current_score,
+                                     score_at(current.x + 1, current.y));
+    float offset_y = parabolicOffset(score_at(current.x, current.y - 1), current_score,
+                                     score_at(current.x, current.y + 1));
+    
+    return cv::Point2f(current.x + offset_x, current.y + offset_y);
+}
@@ -0,0 +1,65 @@
+#include "KeyBackend.h"
+#include <iostream>
+
+bool RecordingKeyBackend::open() {
+    opened = true;
+    return true;
+}
+
+void RecordingKeyBackend::close() {
+    opened = false;
+}
+
+void RecordingKeyBackend::press(InjectedKey key) {
+    std::lock_guard<std::mutex> lock(events_mutex);
+    recorded.push_back({key, true, std::chrono::steady_clock::now()});
+}
+
+void RecordingKeyBackend::release(InjectedKey key) {
+    std::lock_guard<std::mutex> lock(events_mutex);
+    recorded.push_back({key, false, std::chrono::steady_clock::now()});
+}
+
+std::vector<RecordedKeyEvent> RecordingKeyBackend::events() const {
+    std::lock_guard<std::mutex> lock(events_mutex);
+    return recorded;
+}
+
+// 対応していないプラットフォームでは nullptr を返す
+#ifndef _WIN32
+std::unique_ptr<KeyBackend> createWindowsKeyBackend() {
+    return nullptr;
+}
+#endif
+
+#ifndef EYE_TRACKER_HAVE_XTEST
+std::unique_ptr<KeyBackend> createXTestKeyBackend() {
+    return nullptr;
+}
+#endif
+
+#ifndef __linux__
+std::unique_ptr<KeyBackend> createUinputKeyBackend() {
+    return nullptr;
+}
+#endif
+
+std::unique_ptr<KeyBackend> createDefaultKeyBackend() {
+    std::unique_ptr<KeyBackend> (*factories[])() = {
+        createWindowsKeyBackend,
+        createXTestKeyBackend,
+        createUinputKeyBackend,
+    };
+    
+    for (auto factory : factories) {
+        std::unique_ptr<KeyBackend> backend = factory();
+        // 開けたものをそのまま返す（KeyInjector::start() の open() は開いていれば何もしない。
+        // uinput の仮想デバイスを作り直さないため）
+        if (backend && backend->open()) {
+            return backend;
+        }
+    }
+    
+    std::cerr << "No key injection backend available; key presses are only recorded" << std::endl;
+    return std::make_unique<RecordingKeyBackend>();
+}
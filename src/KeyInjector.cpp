@@ -0,0 +1,163 @@
+#include "KeyInjector.h"
+#include <iostream>
+
+namespace {
+
+// 解放待ちのキーがないときの最大待機（stop() は通知で即座に起こす）
+const std::chrono::milliseconds IDLE_WAIT(100);
+
+}
+
+KeyInjector::KeyInjector(std::unique_ptr<KeyBackend> key_backend, std::chrono::milliseconds hold)
+    : backend(std::move(key_backend)), hold_time(hold), queue(QUEUE_CAPACITY),
+      running(false), sent_count(0), dropped_count(0), merged_count(0), metrics(nullptr) {
+}
+
+KeyInjector::~KeyInjector() {
+    stop();
+}
+
+bool KeyInjector::start() {
+    if (running) {
+        return true;
+    }
+    if (!backend || !backend->open()) {
+        std::cerr << "Failed to open key backend: " << backendName() << std::endl;
+        return false;
+    }
+    
+    running = true;
+    worker = std::thread(&KeyInjector::workerLoop, this);
+    return true;
+}
+
+void KeyInjector::stop() {
+    if (!worker.joinable()) {
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        running = false;
+    }
+    wake.notify_one();
+    worker.join();
+    backend->close();
+}
+
+bool KeyInjector::send(InjectedKey key, Clock::time_point requested) {
+    KeyCommand command;
+    command.key = key;
+    command.requested = requested;
+    command.queued = Clock::now();
+    if (!queue.tryPush(command)) {
+        dropped_count.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    
+    // 待機に入る直前の通知を取りこぼさないよう、mutex を一瞬だけ通す
+    { std::lock_guard<std::mutex> lock(wake_mutex); }
+    wake.notify_one();
+    return true;
+}
+
+void KeyInjector::workerLoop() {
+    KeyCommand command;
+    
+    while (true) {
+        Clock::time_point now = Clock::now();
+        releaseDue(now, false);
+        
+        while (queue.tryPop(command)) {
+            pressKey(command, Clock::now());
+        }
+        
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        if (!running) {
+            break;
+        }
+        // 次の解放期限（なければ IDLE_WAIT）まで、新しいキーか停止要求が来るのを待つ
+        wake.wait_until(lock, nextDeadline(Clock::now() + IDLE_WAIT),
+                        [this] { return !running || !queue.empty(); });
+    }
+    
+    // 終了時: 残りのキーを押して、押しっぱなしにならないよう全て解放する
+    while (queue.tryPop(command)) {
+        pressKey(command, Clock::now());
+    }
+    releaseDue(Clock::now(), true);
+}
+
+void KeyInjector::pressKey(const KeyCommand& command, Clock::time_point now) {
+    // 押下中の同じキーは、今の押下を hold_time だけ保ってから解放し、押し直す
+    // （期限を延ばすだけだと、毎フレーム送られる間ずっと押しっぱなしになり1回の押下にしかならない）
+    for (auto& held : pending) {
+        if (held.active && held.key == command.key) {
+            if (held.repress) {
+                merged_count.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                held.repress = true;
+                held.repress_command = command;
+            }
+            return;
+        }
+    }
+    
+    emitPress(command);
+    
+    for (auto& slot : pending) {
+        if (!slot.active) {
+            slot.key = command.key;
+            slot.release_at = now + hold_time;
+            slot.active = true;
+            slot.repress = false;
+            return;
+        }
+    }
+    // 空きがない（キーの種類数以上は同時に押されない）ので即座に解放する
+    backend->release(command.key);
+}
+
+void KeyInjector::emitPress(const KeyCommand& command) {
+    backend->press(command.key);
+    sent_count.fetch_add(1, std::memory_order_relaxed);
+    
+    // キーが出た時点を終点とする（バックエンドの呼び出しが返った直後）
+    if (PipelineMetrics* target = metrics.load(std::memory_order_acquire)) {
+        Clock::time_point pressed = Clock::now();
+        target->increment(MetricCounter::KeysPressed);
+        target->record(MetricStage::KeyQueue, pressed - command.queued);
+        if (command.requested != Clock::time_point()) {
+            target->record(MetricStage::CaptureToKey, pressed - command.requested);
+        }
+    }
+}
+
+void KeyInjector::releaseDue(Clock::time_point now, bool release_all) {
+    for (auto& held : pending) {
+        if (!held.active || (!release_all && held.release_at > now)) {
+            continue;
+        }
+        backend->release(held.key);
+        
+        // 停止時は押し直さない（押しっぱなしを残さない）
+        if (held.repress && !release_all) {
+            held.repress = false;
+            emitPress(held.repress_command);
+            held.release_at = now + hold_time;
+            continue;
+        }
+        held.active = false;
+        held.repress = false;
+    }
+}
+
+KeyInjector::Clock::time_point KeyInjector::nextDeadline(Clock::time_point idle_deadline) const {
+    Clock::time_point deadline = idle_deadline;
+    for (const auto& held : pending) {
+        if (held.active && held.release_at < deadline) {
+            deadline = held.release_at;
+        }
+    }
+    return deadline;
+}
@@ -0,0 +1,28 @@
+#include "MatArena.h"
+
+MatArena::MatArena() : reserved_size(0, 0) {
+    for (auto& contours : contour_sets) {
+        contours.reserve(RESERVED_CONTOURS);
+    }
+    circle_buffer.reserve(RESERVED_CONTOURS);
+}
+
+void MatArena::reserve(const cv::Size& roi_size) {
+    if (roi_size == reserved_size) {
+        return;
+    }
+    
+    // 全プレーンは8bit単チャンネル
+    for (auto& mat : mats) {
+        mat.create(roi_size, CV_8UC1);
+    }
+    
+    cv::Size level_size = roi_size;
+    for (auto& level : pyramid_levels) {
+        level_size = cv::Size((level_size.width + 1) / 2, (level_size.height + 1) / 2);
+        level.create(level_size, CV_8UC1);
+    }
+    pyramid_binary.create(pyramid_levels[0].size(), CV_8UC1);
+    
+    reserved_size = roi_size;
+}
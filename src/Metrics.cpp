@@ -0,0 +1,252 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+
+namespace {
+
+// Prometheus・CSV に出す分位点
+const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+int highestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1) {
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+}
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+int LatencyHistogram::bucketIndex(uint64_t nanoseconds) {
+    if (nanoseconds < static_cast<uint64_t>(SUB_BUCKETS)) {
+        return static_cast<int>(nanoseconds);
+    }
+    int exponent = highestBit(nanoseconds);
+    if (exponent > MAX_EXPONENT) {
+        return BUCKET_COUNT - 1;
+    }
+    // 最上位ビットの下の SUB_BUCKET_BITS ビットで細分する
+    int sub_bucket = static_cast<int>((nanoseconds >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub_bucket;
+}
+
+uint64_t LatencyHistogram::bucketLowerBound(int index) {
+    if (index < SUB_BUCKETS) {
+        return static_cast<uint64_t>(index);
+    }
+    int exponent = index / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    uint64_t sub_bucket = static_cast<uint64_t>(index % SUB_BUCKETS);
+    return (static_cast<uint64_t>(SUB_BUCKETS) + sub_bucket) << (exponent - SUB_BUCKET_BITS);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index) {
+    if (index < SUB_BUCKETS) {
+        return static_cast<uint64_t>(index);
+    }
+    int exponent = index / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    return bucketLowerBound(index) + (uint64_t(1) << (exponent - SUB_BUCKET_BITS)) - 1;
+}
+
+void LatencyHistogram::record(uint64_t nanoseconds) {
+    buckets[bucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    sum_ns.fetch_add(nanoseconds, std::memory_order_relaxed);
+    
+    uint64_t current_max = max_ns.load(std::memory_order_relaxed);
+    while (nanoseconds > current_max &&
+           !max_ns.compare_exchange_weak(current_max, nanoseconds, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    // 記録中のスレッドがあっても止めない（件数はバケットの合計なので、合計時間とはわずかにずれうる）
+    Snapshot snap;
+    snap.buckets.resize(BUCKET_COUNT);
+    uint64_t total = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        snap.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+        total += snap.buckets[i];
+    }
+    snap.count = total;
+    snap.sum_ns = sum_ns.load(std::memory_order_relaxed);
+    snap.max_ns = max_ns.load(std::memory_order_relaxed);
+    return snap;
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    sum_ns.store(0, std::memory_order_relaxed);
+    max_ns.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::Snapshot::percentileNs(double quantile) const {
+    if (count == 0) {
+        return 0.0;
+    }
+    
+    uint64_t rank = static_cast<uint64_t>(std::ceil(quantile * count));
+    rank = std::max<uint64_t>(1, std::min(rank, count));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            double lower = static_cast<double>(bucketLowerBound(static_cast<int>(i)));
+            double upper = static_cast<double>(bucketUpperBound(static_cast<int>(i)));
+            // 最大値を超えない（最上位のバケットは幅が広いため）
+            return std::min((lower + upper) * 0.5, static_cast<double>(max_ns));
+        }
+    }
+    return static_cast<double>(max_ns);
+}
+
+PipelineMetrics::PipelineMetrics() : enabled(true) {
+    for (auto& counter : counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+void PipelineMetrics::record(MetricStage stage, Clock::duration elapsed) {
+    if (!isEnabled()) {
+        return;
+    }
+    auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    stages[static_cast<size_t>(stage)].record(nanoseconds > 0 ? static_cast<uint64_t>(nanoseconds) : 0);
+}
+
+LatencyHistogram::Snapshot PipelineMetrics::stageSnapshot(MetricStage stage) const {
+    return stages[static_cast<size_t>(stage)].snapshot();
+}
+
+uint64_t PipelineMetrics::counterValue(MetricCounter counter) const {
+    return counters[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+}
+
+void PipelineMetrics::reset() {
+    for (auto& stage : stages) {
+        stage.reset();
+    }
+    for (auto& counter : counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+const char* PipelineMetrics::stageName(MetricStage stage) {
+    switch (stage) {
+        case MetricStage::CaptureWait:     return "capture_wait";
+        case MetricStage::Preprocess:      return "preprocess";
+        case MetricStage::PupilTrack:      return "pupil_track";
+        case MetricStage::Hough:           return "hough";
+        case MetricStage::ContourFallback: return "contour_fallback";
+        case MetricStage::Ear:             return "ear";
+        case MetricStage::Gaze:            return "gaze";
+        case MetricStage::CommandDispatch: return "command_dispatch";
+        case MetricStage::Render:          return "render";
+        case MetricStage::CaptureToAnalysis: return "capture_to_analysis";
+        case MetricStage::KeyQueue:        return "key_queue";
+        case MetricStage::CaptureToKey:    return "capture_to_key";
+        case MetricStage::PoolWait:        return "pool_wait";
+        case MetricStage::COUNT:           break;
+    }
+    return "unknown";
+}
+
+const char* PipelineMetrics::counterName(MetricCounter counter) {
+    switch (counter) {
+        case MetricCounter::FramesCaptured:  return "frames_captured";
+        case MetricCounter::FramesAnalyzed:  return "frames_analyzed";
+        case MetricCounter::FramesPresented: return "frames_presented";
+        case MetricCounter::CaptureDropped:  return "capture_dropped";
+        case MetricCounter::AnalysisDropped: return "analysis_dropped";
+        case MetricCounter::PreviewSkipped:  return "preview_skipped";
+        case MetricCounter::StaleFrames:     return "stale_frames";
+        case MetricCounter::DeadlineDropped: return "deadline_dropped";
+        case MetricCounter::PupilLost:       return "pupil_lost";
+        case MetricCounter::HoughMiss:       return "hough_miss";
+        case MetricCounter::ContourMiss:     return "contour_miss";
+        case MetricCounter::CommandsSent:    return "commands_sent";
+        case MetricCounter::KeysPressed:     return "keys_pressed";
+        case MetricCounter::COUNT:           break;
+    }
+    return "unknown";
+}
+
+void PipelineMetrics::writePrometheus(std::ostream& out) const {
+    out << std::defaultfloat << std::setprecision(6);
+    out << "# HELP eye_tracker_stage_latency_seconds Processing time per pipeline stage.\n";
+    out << "# TYPE eye_tracker_stage_latency_seconds summary\n";
+    for (size_t i = 0; i < stages.size(); i++) {
+        MetricStage stage = static_cast<MetricStage>(i);
+        LatencyHistogram::Snapshot snap = stages[i].snapshot();
+        const char* name = stageName(stage);
+        for (double quantile : QUANTILES) {
+            out << "eye_tracker_stage_latency_seconds{stage=\"" << name << "\",quantile=\"" << quantile << "\"} "
+                << snap.percentileNs(quantile) * 1e-9 << "\n";
+        }
+        out << "eye_tracker_stage_latency_seconds_sum{stage=\"" << name << "\"} " << snap.sum_ns * 1e-9 << "\n";
+        out << "eye_tracker_stage_latency_seconds_count{stage=\"" << name << "\"} " << snap.count << "\n";
+    }
+    
+    out << "# HELP eye_tracker_events_total Pipeline events (frames, drops, detection failures).\n";
+    out << "# TYPE eye_tracker_events_total counter\n";
+    for (size_t i = 0; i < counters.size(); i++) {
+        out << "eye_tracker_events_total{event=\"" << counterName(static_cast<MetricCounter>(i)) << "\"} "
+            << counters[i].load(std::memory_order_relaxed) << "\n";
+    }
+}
+
+void PipelineMetrics::writeCsv(std::ostream& out) const {
+    out << "name,kind,count,mean_us,p50_us,p90_us,p99_us,p999_us,max_us\n";
+    out << std::fixed << std::setprecision(3);
+    // 呼び出し側のストリームの書式は戻さない（ファイルに書く場合は毎回新しいストリーム）
+    for (size_t i = 0; i < stages.size(); i++) {
+        LatencyHistogram::Snapshot snap = stages[i].snapshot();
+        out << stageName(static_cast<MetricStage>(i)) << ",stage," << snap.count << ","
+            << snap.meanNs() / 1000.0;
+        for (double quantile : QUANTILES) {
+            out << "," << snap.percentileNs(quantile) / 1000.0;
+        }
+        out << "," << snap.max_ns / 1000.0 << "\n";
+    }
+    for (size_t i = 0; i < counters.size(); i++) {
+        out << counterName(static_cast<MetricCounter>(i)) << ",counter,"
+            << counters[i].load(std::memory_order_relaxed) << ",,,,,,\n";
+    }
+}
+
+bool PipelineMetrics::writeFile(const std::string& path) const {
+    bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        if (csv) {
+            writeCsv(file);
+        } else {
+            writePrometheus(file);
+        }
+        if (!file) {
+            return false;
+        }
+    }
+    
+    // 収集側が書きかけのファイルを読まないよう置き換える
+    // POSIX の rename は既存のファイルを原子的に置き換える。Windows では既存があると失敗するので先に消す
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    return std::rename(temp_path.c_str(), path.c_str()) == 0;
+}
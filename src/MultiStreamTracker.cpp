@@ -0,0 +1,122 @@
+#include "MultiStreamTracker.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+// 全セッションの終了・停止の要求を確かめる間隔
+const std::chrono::milliseconds RUN_POLL(20);
+
+}
+
+MultiStreamTracker::MultiStreamTracker(size_t workers)
+    : worker_count(workers), stop_requested(false) {
+}
+
+MultiStreamTracker::~MultiStreamTracker() {
+    // セッションのタスクはプールを参照するため、セッションを先に止める
+    for (auto& session : sessions) {
+        session->stop();
+    }
+    sessions.clear();
+    pool.reset();
+}
+
+void MultiStreamTracker::applyConfig(const EyeTrackingConfig& new_config) {
+    config = new_config;
+    for (auto& session : sessions) {
+        session->applyConfig(config);
+    }
+}
+
+void MultiStreamTracker::addSession(const std::string& name, std::unique_ptr<FrameSource> source,
+                                    std::unique_ptr<KeyBackend> key_backend) {
+    auto session = std::make_unique<TrackerSession>(name, std::move(source), std::move(key_backend));
+    session->applyConfig(config);
+    sessions.push_back(std::move(session));
+}
+
+bool MultiStreamTracker::run() {
+    if (sessions.empty()) {
+        return false;
+    }
+    
+    if (!pool) {
+        pool = std::make_unique<WorkStealingPool>(worker_count);
+    }
+    stop_requested = false;
+    for (auto& session : sessions) {
+        if (!session->start(*pool)) {
+            std::cerr << session->name() << ": failed to start" << std::endl;
+        }
+    }
+    
+    while (!stop_requested) {
+        bool all_finished = std::all_of(sessions.begin(), sessions.end(),
+            [](const std::unique_ptr<TrackerSession>& session) { return session->isFinished(); });
+        if (all_finished) {
+            break;
+        }
+        std::this_thread::sleep_for(RUN_POLL);
+    }
+    
+    for (auto& session : sessions) {
+        session->stop();
+    }
+    return true;
+}
+
+MultiStreamReport MultiStreamTracker::report() const {
+    MultiStreamReport result;
+    result.workers = pool ? pool->threadCount() : 0;
+    result.stolen_tasks = pool ? pool->stolenCount() : 0;
+    
+    double fps_sum = 0.0;
+    double fps_square_sum = 0.0;
+    uint64_t total_frames = 0;
+    for (const auto& session : sessions) {
+        const PipelineMetrics& metrics = session->getMetrics();
+        LatencyHistogram::Snapshot latency = metrics.stageSnapshot(MetricStage::CaptureToAnalysis);
+        LatencyHistogram::Snapshot wait = metrics.stageSnapshot(MetricStage::PoolWait);
+        
+        StreamReport stream;
+        stream.name = session->name();
+        stream.frames = session->framesAnalyzed();
+        stream.dropped = metrics.counterValue(MetricCounter::CaptureDropped);
+        stream.seconds = session->elapsedSeconds();
+        stream.fps = stream.seconds > 0 ? stream.frames / stream.seconds : 0.0;
+        stream.pool_wait_p99_ms = wait.percentileNs(0.99) * 1e-6;
+        stream.latency_p50_ms = latency.percentileNs(0.5) * 1e-6;
+        stream.latency_p99_ms = latency.percentileNs(0.99) * 1e-6;
+        
+        fps_sum += stream.fps;
+        fps_square_sum += stream.fps * stream.fps;
+        total_frames += stream.frames;
+        result.seconds = std::max(result.seconds, stream.seconds);
+        result.streams.push_back(stream);
+    }
+    
+    result.total_fps = result.seconds > 0 ? total_frames / result.seconds : 0.0;
+    if (fps_square_sum > 0) {
+        result.fairness = fps_sum * fps_sum / (result.streams.size() * fps_square_sum);
+    }
+    return result;
+}
+
+void MultiStreamTracker::printReport(const MultiStreamReport& report, std::ostream& out) {
+    out << "stream                  frames  dropped      fps  wait_p99_ms  lat_p50_ms  lat_p99_ms" << std::endl;
+    out << std::fixed << std::setprecision(2);
+    for (const auto& stream : report.streams) {
+        out << std::left << std::setw(20) << stream.name << std::right
+            << std::setw(10) << stream.frames
+            << std::setw(9) << stream.dropped
+            << std::setw(9) << stream.fps
+            << std::setw(13) << stream.pool_wait_p99_ms
+            << std::setw(12) << stream.latency_p50_ms
+            << std::setw(12) << stream.latency_p99_ms << std::endl;
+    }
+    out << "total: " << report.total_fps << " frames/s on " << report.workers << " workers, fairness "
+        << std::setprecision(3) << report.fairness << ", " << report.stolen_tasks << " stolen tasks" << std::endl;
+    out << std::defaultfloat;
+}
@@ -0,0 +1,60 @@
+#include "PreprocessCache.h"
+
+PreprocessCache::PreprocessCache() : valid_planes(0) {
+}
+
+PreprocessCache::PreprocessCache(const cv::Mat& eye_roi) : valid_planes(0) {
+    reset(eye_roi);
+}
+
+void PreprocessCache::reset(const cv::Mat& eye_roi) {
+    source_roi = eye_roi;
+    valid_planes = 0;
+    buffers.reserve(eye_roi.size());
+}
+
+const cv::Mat& PreprocessCache::gray() {
+    // 既にグレースケールならそのまま参照する
+    // （アリーナのバッファに代入すると前フレームの画像を上書きしてしまうため）
+    if (source_roi.channels() != 3) {
+        return source_roi;
+    }
+    
+    cv::Mat& gray_plane = buffers.mat(MatArena::MAT_GRAY);
+    if (!(valid_planes & PLANE_GRAY)) {
+        cv::cvtColor(source_roi, gray_plane, cv::COLOR_BGR2GRAY);
+        valid_planes |= PLANE_GRAY;
+    }
+    return gray_plane;
+}
+
+const cv::Mat& PreprocessCache::blurred() {
+    cv::Mat& blurred_plane = buffers.mat(MatArena::MAT_BLURRED);
+    if (!(valid_planes & PLANE_BLURRED)) {
+        // ガウシアンブラーでノイズ除去
+        cv::GaussianBlur(gray(), blurred_plane, cv::Size(5, 5), 0);
+        valid_planes |= PLANE_BLURRED;
+    }
+    return blurred_plane;
+}
+
+const cv::Mat& PreprocessCache::adaptiveBinary() {
+    cv::Mat& adaptive_plane = buffers.mat(MatArena::MAT_ADAPTIVE);
+    if (!(valid_planes & PLANE_ADAPTIVE)) {
+        // 適応的閾値処理
+        cv::adaptiveThreshold(blurred(), adaptive_plane, 255,
+                             cv::ADAPTIVE_THRESH_MEAN_C,
+                             cv::THRESH_BINARY, 11, 2);
+        valid_planes |= PLANE_ADAPTIVE;
+    }
+    return adaptive_plane;
+}
+
+const cv::Mat& PreprocessCache::otsuBinary() {
+    cv::Mat& otsu_plane = buffers.mat(MatArena::MAT_OTSU);
+    if (!(valid_planes & PLANE_OTSU)) {
+        cv::threshold(gray(), otsu_plane, 0, 255, cv::THRESH_BINARY + cv::THRESH_OTSU);
+        valid_planes |= PLANE_OTSU;
+    }
+    return otsu_plane;
+}
@@ -0,0 +1,166 @@
+#include "PupilTracker.h"
+#include <algorithm>
+
+namespace {
+
+const double DEFAULT_FRAME_INTERVAL_S = 1.0 / 30.0;
+const int MIN_SEARCH_RADIUS = 8;         // 小窓の半径の下限（px）
+const int SEARCH_RADIUS_DIVISOR = 6;     // 小窓の半径 = 画像の短辺 / この値
+const double MIN_PUPIL_CONTRAST = 25.0;  // 窓の平均と最暗部の差がこれ未満なら瞳孔なし（閉眼）
+const double DARK_LEVEL_RATIO = 0.35;    // 最暗部から平均までのこの割合までを瞳孔とみなす
+const int MIN_BLOB_AREA = 4;
+const double MAX_BLOB_ASPECT = 2.5;      // まつ毛の線のような細長い領域を除く
+const double MIN_BLOB_FILL = 0.4;        // 外接矩形に対する面積の割合
+const double MAX_BLOB_WINDOW_RATIO = 0.5;
+const uchar BLOB_LABEL = 128;
+
+}
+
+PupilTracker::PupilTracker(double position_gain, double velocity_gain,
+                           std::chrono::milliseconds coast_limit, int redetect_frames)
+    : alpha(position_gain), beta(velocity_gain), max_coast(coast_limit),
+      redetect_interval(redetect_frames), window_confirmed(false),
+      full_detections(0), window_confirmations(0), predicted_frames(0) {
+    reset();
+}
+
+void PupilTracker::reset() {
+    track_state = PupilTrackState::Lost;
+    position = cv::Point2f(-1, -1);
+    velocity = cv::Point2f(0, 0);
+    frames_since_detection = 0;
+    window_confirmed = false;
+}
+
+cv::Point2f PupilTracker::track(PreprocessCache& cache, std::chrono::steady_clock::time_point timestamp,
+                                GazeEstimator& estimator) {
+    double dt = DEFAULT_FRAME_INTERVAL_S;
+    if (track_state != PupilTrackState::Lost) {
+        double elapsed = std::chrono::duration<double>(timestamp - last_update).count();
+        if (elapsed > 0) {
+            dt = elapsed;
+        }
+    }
+    last_update = timestamp;
+    window_confirmed = false;
+    
+    cv::Point2f measurement;
+    if (track_state == PupilTrackState::Lost) {
+        if (!detectFull(cache, estimator, measurement)) {
+            return cv::Point2f(-1, -1);
+        }
+        initializeTrack(measurement);
+        last_confirmed = timestamp;
+        return position;
+    }
+    
+    cv::Point2f predicted = position + velocity * static_cast<float>(dt);
+    
+    // 一定フレームごとに全体検出で補正する（小窓探索の取り違えが続かないように）
+    if (frames_since_detection >= redetect_interval && detectFull(cache, estimator, measurement)) {
+        initializeTrack(measurement);
+        last_confirmed = timestamp;
+        return position;
+    }
+    
+    if (searchWindow(cache, predicted, measurement)) {
+        window_confirmations++;
+        frames_since_detection++;
+        correct(predicted, measurement, dt);
+        track_state = PupilTrackState::Confirmed;
+        window_confirmed = true;
+        last_confirmed = timestamp;
+        return position;
+    }
+    
+    // 確認できなかった: 瞬き中は瞳孔がほぼ動かないので、予測位置で止めておく
+    position = predicted;
+    velocity = cv::Point2f(0, 0);
+    if (timestamp - last_confirmed <= max_coast) {
+        track_state = PupilTrackState::Predicted;
+        predicted_frames++;
+        return cv::Point2f(-1, -1);
+    }
+    
+    // 見失った: 次のフレームを待たずにこのフレームで全体検出する
+    if (detectFull(cache, estimator, measurement)) {
+        initializeTrack(measurement);
+        last_confirmed = timestamp;
+        return position;
+    }
+    
+    reset();
+    return cv::Point2f(-1, -1);
+}
+
+bool PupilTracker::detectFull(PreprocessCache& cache, GazeEstimator& estimator, cv::Point2f& found) {
+    full_detections++;
+    frames_since_detection = 0;
+    found = estimator.detectPupilCenter(cache);
+    return found.x >= 0 && found.y >= 0;
+}
+
+bool PupilTracker::searchWindow(PreprocessCache& cache, const cv::Point2f& predicted, cv::Point2f& found) {
+    const cv::Mat& gray = cache.gray();
+    int radius = std::max(MIN_SEARCH_RADIUS, std::min(gray.cols, gray.rows) / SEARCH_RADIUS_DIVISOR);
+    cv::Rect window = cv::Rect(cvRound(predicted.x) - radius, cvRound(predicted.y) - radius,
+                               radius * 2 + 1, radius * 2 + 1) &
+                      cv::Rect(0, 0, gray.cols, gray.rows);
+    if (window.width < 5 || window.height < 5) {
+        return false;
+    }
+    
+    // 窓の中だけをぼかして最暗部を探す
+    cv::GaussianBlur(gray(window), window_blurred, cv::Size(5, 5), 0);
+    double min_value = 0;
+    cv::Point min_location;
+    cv::minMaxLoc(window_blurred, &min_value, nullptr, &min_location);
+    double mean_value = cv::mean(window_blurred)[0];
+    if (mean_value - min_value < MIN_PUPIL_CONTRAST) {
+        return false;
+    }
+    
+    // 最暗部とつながった暗い領域だけを瞳孔候補にする
+    double threshold = min_value + (mean_value - min_value) * DARK_LEVEL_RATIO;
+    cv::threshold(window_blurred, window_binary, threshold, 255, cv::THRESH_BINARY_INV);
+    cv::Rect blob;
+    int area = cv::floodFill(window_binary, min_location, cv::Scalar(BLOB_LABEL), &blob,
+                             cv::Scalar(0), cv::Scalar(0), 4);
+    
+    if (area < MIN_BLOB_AREA || area > window.area() * MAX_BLOB_WINDOW_RATIO) {
+        return false;
+    }
+    int long_side = std::max(blob.width, blob.height);
+    int short_side = std::min(blob.width, blob.height);
+    if (long_side > short_side * MAX_BLOB_ASPECT || area < blob.area() * MIN_BLOB_FILL) {
+        return false;
+    }
+    
+    double sum_x = 0;
+    double sum_y = 0;
+    for (int y = blob.y; y < blob.y + blob.height; y++) {
+        const uchar* row = window_binary.ptr<uchar>(y);
+        for (int x = blob.x; x < blob.x + blob.width; x++) {
+            if (row[x] == BLOB_LABEL) {
+                sum_x += x;
+                sum_y += y;
+            }
+        }
+    }
+    
+    found = cv::Point2f(static_cast<float>(window.x + sum_x / area),
+                        static_cast<float>(window.y + sum_y / area));
+    return true;
+}
+
+void PupilTracker::initializeTrack(const cv::Point2f& measurement) {
+    position = measurement;
+    velocity = cv::Point2f(0, 0);
+    track_state = PupilTrackState::Confirmed;
+}
+
+void PupilTracker::correct(const cv::Point2f& predicted, const cv::Point2f& measurement, double dt) {
+    cv::Point2f residual = measurement - predicted;
+    position = predicted + residual * static_cast<float>(alpha);
+    velocity += residual * static_cast<float>(beta / dt);
+}
@@ -0,0 +1,184 @@
+#include "ReplaySource.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+bool isImageFile(const std::filesystem::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext == ".png" || ext == ".jpg" || ext == ".jpeg" ||
+           ext == ".bmp" || ext == ".tif" || ext == ".tiff";
+}
+
+// ファイル名中の最後の数字列（フレーム番号）を取り出す。なければ -1
+long long frameNumber(const std::string& name) {
+    size_t end = name.find_last_of("0123456789");
+    if (end == std::string::npos) {
+        return -1;
+    }
+    size_t begin = end;
+    while (begin > 0 && std::isdigit(static_cast<unsigned char>(name[begin - 1]))) {
+        begin--;
+    }
+    return std::stoll(name.substr(begin, end - begin + 1));
+}
+
+}
+
+ReplaySource::ReplaySource()
+    : image_index(0), is_image_sequence(false), pacing(ReplayPacing::Realtime),
+      frame_rate(30.0), frame_index(0), frame_size(0, 0),
+      recorded_start(0), started(false) {
+}
+
+bool ReplaySource::open(const std::string& path, ReplayPacing replay_pacing,
+                        double default_fps) {
+    release();
+    pacing = replay_pacing;
+    frame_rate = default_fps;
+    frame_index = 0;
+    started = false;
+    
+    std::error_code ec;
+    if (std::filesystem::is_directory(path, ec)) {
+        for (const auto& entry : std::filesystem::directory_iterator(path, ec)) {
+            if (entry.is_regular_file() && isImageFile(entry.path())) {
+                image_files.push_back(entry.path().string());
+            }
+        }
+        
+        // 連番順に並べる（桁数の揃っていない番号にも対応）
+        std::sort(image_files.begin(), image_files.end(),
+            [](const std::string& a, const std::string& b) {
+                std::string name_a = std::filesystem::path(a).filename().string();
+                std::string name_b = std::filesystem::path(b).filename().string();
+                long long num_a = frameNumber(name_a);
+                long long num_b = frameNumber(name_b);
+                if (num_a != num_b) {
+                    return num_a < num_b;
+                }
+                return name_a < name_b;
+            });
+        
+        if (image_files.empty()) {
+            std::cerr << "No images found in " << path << std::endl;
+            return false;
+        }
+        
+        cv::Mat first = cv::imread(image_files.front());
+        if (first.empty()) {
+            std::cerr << "Failed to read " << image_files.front() << std::endl;
+            image_files.clear();
+            return false;
+        }
+        frame_size = first.size();
+        is_image_sequence = true;
+        return true;
+    }
+    
+    if (!video.open(path)) {
+        std::cerr << "Failed to open replay file " << path << std::endl;
+        return false;
+    }
+    
+    double recorded_fps = video.get(cv::CAP_PROP_FPS);
+    if (recorded_fps > 0) {
+        frame_rate = recorded_fps;
+    }
+    frame_size = cv::Size(static_cast<int>(video.get(cv::CAP_PROP_FRAME_WIDTH)),
+                          static_cast<int>(video.get(cv::CAP_PROP_FRAME_HEIGHT)));
+    is_image_sequence = false;
+    return true;
+}
+
+bool ReplaySource::isOpened() const {
+    return is_image_sequence ? image_index < image_files.size() : video.isOpened();
+}
+
+void ReplaySource::release() {
+    if (video.isOpened()) {
+        video.release();
+    }
+    image_files.clear();
+    image_index = 0;
+    is_image_sequence = false;
+}
+
+bool ReplaySource::read(cv::Mat& frame, Clock::time_point& timestamp) {
+    Clock::duration recorded_time;
+    if (!readNext(frame, recorded_time)) {
+        return false;
+    }
+    
+    if (pacing == ReplayPacing::Realtime) {
+        waitForRecordedTime(recorded_time);
+    }
+    
+    // 実時刻ではなく記録上の時刻をタイムスタンプにする
+    // 遅延の起点は、撮影の代わりにフレームを供給した実時刻とする
+    timestamp = Clock::time_point(recorded_time);
+    last_capture_time = Clock::now();
+    return true;
+}
+
+bool ReplaySource::skip() {
+    if (is_image_sequence) {
+        if (image_index >= image_files.size()) {
+            return false;
+        }
+        image_index++;
+        frame_index++;
+        return true;
+    }
+    if (!video.grab()) {
+        return false;
+    }
+    frame_index++;
+    return true;
+}
+
+bool ReplaySource::readNext(cv::Mat& frame, Clock::duration& recorded_time) {
+    // フレーム番号から求めた時刻（コンテナが時刻を持たない場合に使う）
+    auto indexed_time = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(frame_index / frame_rate));
+    
+    if (is_image_sequence) {
+        if (image_index >= image_files.size()) {
+            return false;
+        }
+        frame = cv::imread(image_files[image_index++]);
+        if (frame.empty()) {
+            return false;
+        }
+        recorded_time = indexed_time;
+    } else {
+        if (!video.read(frame) || frame.empty()) {
+            return false;
+        }
+        double pos_msec = video.get(cv::CAP_PROP_POS_MSEC);
+        if (pos_msec > 0 || frame_index == 0) {
+            recorded_time = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::milli>(pos_msec));
+        } else {
+            recorded_time = indexed_time;
+        }
+    }
+    
+    frame_index++;
+    return true;
+}
+
+void ReplaySource::waitForRecordedTime(Clock::duration recorded_time) {
+    if (!started) {
+        wall_start = Clock::now();
+        recorded_start = recorded_time;
+        started = true;
+        return;
+    }
+    std::this_thread::sleep_until(wall_start + (recorded_time - recorded_start));
+}
@@ -0,0 +1,253 @@
+#include "SyntheticEyeGenerator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const int LID_SAMPLES = 24;            // まぶた1本あたりの折れ線の点数
+const double EYE_MARGIN_RATIO = 0.08;  // 画像端から目の角までの余白
+const double MAX_UPPER_OPEN = 0.42;    // 全開時の上まぶたの高さ（画像高さ比）
+const double MAX_LOWER_OPEN = 0.30;    // 全開時の下まぶたの深さ（画像高さ比）
+const double PI = 3.14159265358979323846;
+
+const cv::Scalar SKIN_COLOR(150, 170, 205);
+const double SCLERA_LEVEL = 230.0;
+const double PUPIL_LEVEL = 25.0;
+
+// 瞬きの予定（周期内の開始時刻、秒）。2つ目と3つ目はダブル瞬き
+const double BLINK_PERIOD_S = 6.0;
+const double BLINK_STARTS_S[] = { 1.0, 4.0, 4.45 };
+const double BLINK_CLOSING_S = 0.05;
+const double BLINK_CLOSED_S = 0.15;
+
+double lerp(double a, double b, double t) {
+    return a + (b - a) * t;
+}
+
+// 瞬き開始からの経過時間に対する開き具合
+double blinkAperture(double elapsed) {
+    if (elapsed < 0) {
+        return 1.0;
+    }
+    if (elapsed < BLINK_CLOSING_S) {
+        return 1.0 - elapsed / BLINK_CLOSING_S;
+    }
+    elapsed -= BLINK_CLOSING_S;
+    if (elapsed < BLINK_CLOSED_S) {
+        return 0.0;
+    }
+    elapsed -= BLINK_CLOSED_S;
+    if (elapsed < BLINK_CLOSING_S) {
+        return elapsed / BLINK_CLOSING_S;
+    }
+    return 1.0;
+}
+
+}
+
+SyntheticEyeGenerator::SyntheticEyeGenerator(uint64_t seed) : rng(seed) {
+    lid_polygon.reserve(LID_SAMPLES * 2);
+}
+
+double SyntheticEyeGenerator::computeEAR(const std::array<cv::Point2f, 6>& p) {
+    double vertical_1 = cv::norm(p[1] - p[5]);
+    double vertical_2 = cv::norm(p[2] - p[4]);
+    double horizontal = cv::norm(p[0] - p[3]);
+    if (horizontal <= 0) {
+        return 0.0;
+    }
+    return (vertical_1 + vertical_2) / (2.0 * horizontal);
+}
+
+void SyntheticEyeGenerator::computeLidShape(const SyntheticEyeParams& params,
+                                            SyntheticEyeLabel& label) {
+    const cv::Size& size = params.size;
+    double aperture = std::min(1.0, std::max(0.0, params.eyelid_aperture));
+    double margin = size.width * EYE_MARGIN_RATIO;
+    double center_x = size.width * 0.5;
+    double center_y = size.height * 0.5;
+    double half_width = center_x - margin;
+    double upper_open = MAX_UPPER_OPEN * size.height * aperture;
+    double lower_open = MAX_LOWER_OPEN * size.height * aperture;
+    
+    // まぶたは目の角を通る放物線で近似する
+    auto upper_y = [&](double t) { return center_y - upper_open * (1.0 - t * t); };
+    auto lower_y = [&](double t) { return center_y + lower_open * (1.0 - t * t); };
+    
+    lid_polygon.clear();
+    for (int i = 0; i < LID_SAMPLES; i++) {
+        double t = -1.0 + 2.0 * i / (LID_SAMPLES - 1);
+        lid_polygon.emplace_back(cvRound(center_x + t * half_width), cvRound(upper_y(t)));
+    }
+    for (int i = LID_SAMPLES - 1; i >= 0; i--) {
+        double t = -1.0 + 2.0 * i / (LID_SAMPLES - 1);
+        lid_polygon.emplace_back(cvRound(center_x + t * half_width), cvRound(lower_y(t)));
+    }
+    
+    const double third = 1.0 / 3.0;
+    label.lid_landmarks[0] = cv::Point2f(center_x - half_width, center_y);
+    label.lid_landmarks[1] = cv::Point2f(center_x - third * half_width, upper_y(-third));
+    label.lid_landmarks[2] = cv::Point2f(center_x + third * half_width, upper_y(third));
+    label.lid_landmarks[3] = cv::Point2f(center_x + half_width, center_y);
+    label.lid_landmarks[4] = cv::Point2f(center_x + third * half_width, lower_y(third));
+    label.lid_landmarks[5] = cv::Point2f(center_x - third * half_width, lower_y(-third));
+    label.ear = computeEAR(label.lid_landmarks);
+    label.eyelid_aperture = aperture;
+    
+    double t = (params.pupil_center.x - center_x) / half_width;
+    label.pupil_visible = aperture > 0 && std::abs(t) < 1.0 &&
+                          params.pupil_center.y > upper_y(t) &&
+                          params.pupil_center.y < lower_y(t);
+}
+
+void SyntheticEyeGenerator::applyLighting(const SyntheticEyeParams& params, cv::Mat& image) {
+    if (params.brightness == 1.0 && params.lighting_gradient == 0.0) {
+        return;
+    }
+    
+    // 列ごとのゲイン（左右方向の照明ムラ）
+    column_gain.resize(image.cols);
+    for (int x = 0; x < image.cols; x++) {
+        double position = static_cast<double>(x) / std::max(1, image.cols - 1) - 0.5;
+        column_gain[x] = static_cast<float>(params.brightness * (1.0 + params.lighting_gradient * position));
+    }
+    
+    for (int y = 0; y < image.rows; y++) {
+        uchar* row = image.ptr<uchar>(y);
+        for (int x = 0; x < image.cols; x++) {
+            float gain = column_gain[x];
+            for (int c = 0; c < 3; c++) {
+                row[x * 3 + c] = cv::saturate_cast<uchar>(row[x * 3 + c] * gain);
+            }
+        }
+    }
+}
+
+void SyntheticEyeGenerator::render(const SyntheticEyeParams& params, cv::Mat& image,
+                                   SyntheticEyeLabel& label) {
+    image.create(params.size, CV_8UC3);
+    eye_layer.create(params.size, CV_8UC3);
+    lid_mask.create(params.size, CV_8UC1);
+    
+    computeLidShape(params, label);
+    label.pupil_center = params.pupil_center;
+    label.pupil_radius = params.pupil_radius;
+    
+    // 眼球（白目・虹彩・瞳孔・角膜反射）
+    double iris_level = lerp(SCLERA_LEVEL, PUPIL_LEVEL, params.iris_contrast);
+    eye_layer.setTo(cv::Scalar::all(SCLERA_LEVEL));
+    cv::circle(eye_layer, params.pupil_center, cvRound(params.iris_radius),
+               cv::Scalar(iris_level * 1.2, iris_level, iris_level * 0.8), -1, cv::LINE_AA);
+    cv::circle(eye_layer, params.pupil_center, cvRound(params.pupil_radius),
+               cv::Scalar::all(PUPIL_LEVEL), -1, cv::LINE_AA);
+    if (params.glint) {
+        cv::Point2f glint_pos = params.pupil_center +
+            cv::Point2f(-0.35f * params.pupil_radius, -0.35f * params.pupil_radius);
+        cv::circle(eye_layer, glint_pos, std::max(1, cvRound(params.pupil_radius * 0.2f)),
+                   cv::Scalar::all(250), -1, cv::LINE_AA);
+    }
+    
+    // 肌の上に、まぶたの開口部だけ眼球を合成する
+    image.setTo(SKIN_COLOR);
+    lid_mask.setTo(cv::Scalar(0));
+    if (label.eyelid_aperture > 0) {
+        const cv::Point* points = lid_polygon.data();
+        int point_count = static_cast<int>(lid_polygon.size());
+        cv::fillPoly(lid_mask, &points, &point_count, 1, cv::Scalar(255));
+        eye_layer.copyTo(image, lid_mask);
+    }
+    
+    // 上まぶたの縁（まつ毛）
+    const cv::Point* upper_points = lid_polygon.data();
+    int upper_count = LID_SAMPLES;
+    cv::polylines(image, &upper_points, &upper_count, 1, false,
+                  cv::Scalar(40, 40, 50), std::max(1, params.size.height / 60), cv::LINE_AA);
+    
+    applyLighting(params, image);
+    
+    if (params.noise_sigma > 0) {
+        noise_buffer.create(params.size, CV_16SC3);
+        rng.fill(noise_buffer, cv::RNG::NORMAL, cv::Scalar::all(0), cv::Scalar::all(params.noise_sigma));
+        cv::add(image, noise_buffer, image, cv::noArray(), CV_8U);
+    }
+    
+    if (params.blur_kernel >= 3) {
+        int kernel = params.blur_kernel | 1;
+        cv::GaussianBlur(image, image, cv::Size(kernel, kernel), 0);
+    }
+}
+
+SyntheticEyeParams SyntheticEyeGenerator::randomParams(const cv::Size& size,
+                                                       double closed_probability) {
+    SyntheticEyeParams params;
+    params.size = size;
+    
+    params.pupil_radius = static_cast<float>(size.height * rng.uniform(0.06, 0.12));
+    params.iris_radius = params.pupil_radius * static_cast<float>(rng.uniform(1.8, 2.6));
+    
+    double half_width = size.width * (0.5 - EYE_MARGIN_RATIO);
+    params.pupil_center = cv::Point2f(
+        static_cast<float>(size.width * 0.5 + rng.uniform(-0.25, 0.25) * half_width),
+        static_cast<float>(size.height * 0.5 + rng.uniform(-0.12, 0.12) * size.height));
+    
+    params.eyelid_aperture = rng.uniform(0.0, 1.0) < closed_probability
+        ? rng.uniform(0.0, 0.2)
+        : rng.uniform(0.6, 1.0);
+    params.iris_contrast = rng.uniform(0.3, 0.9);
+    params.noise_sigma = rng.uniform(0.0, 10.0);
+    const int blur_choices[] = { 0, 3, 5 };
+    params.blur_kernel = blur_choices[rng.uniform(0, 3)];
+    params.brightness = rng.uniform(0.7, 1.2);
+    params.lighting_gradient = rng.uniform(-0.4, 0.4);
+    params.glint = rng.uniform(0.0, 1.0) < 0.8;
+    return params;
+}
+
+SyntheticEyeSource::SyntheticEyeSource(const cv::Size& size, double fps,
+                                       uint64_t frame_count, uint64_t seed)
+    : generator(seed), frame_rate(fps), frame_index(0), frame_limit(frame_count),
+      opened(true) {
+    base_params.size = size;
+    base_params.pupil_radius = size.height * 0.08f;
+    base_params.iris_radius = base_params.pupil_radius * 2.2f;
+    base_params.pupil_center = cv::Point2f(size.width * 0.5f, size.height * 0.5f);
+}
+
+SyntheticEyeParams SyntheticEyeSource::paramsAt(uint64_t index) const {
+    SyntheticEyeParams params = base_params;
+    double t = index / frame_rate;
+    
+    // 瞳孔はリサージュ曲線で動かす
+    double half_width = params.size.width * (0.5 - EYE_MARGIN_RATIO);
+    params.pupil_center.x += static_cast<float>(0.25 * half_width * std::sin(2 * PI * 0.23 * t));
+    params.pupil_center.y += static_cast<float>(0.10 * params.size.height * std::sin(2 * PI * 0.17 * t + 1.0));
+    
+    double phase = std::fmod(t, BLINK_PERIOD_S);
+    double aperture = 1.0;
+    for (double start : BLINK_STARTS_S) {
+        aperture = std::min(aperture, blinkAperture(phase - start));
+    }
+    params.eyelid_aperture = aperture;
+    return params;
+}
+
+bool SyntheticEyeSource::read(cv::Mat& frame, Clock::time_point& timestamp) {
+    if (!opened || (frame_limit > 0 && frame_index >= frame_limit)) {
+        return false;
+    }
+    
+    generator.render(paramsAt(frame_index), frame, last_label);
+    last_capture_time = Clock::now();
+    timestamp = Clock::time_point(std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(frame_index / frame_rate)));
+    frame_index++;
+    return true;
+}
+
+bool SyntheticEyeSource::skip() {
+    if (!opened || (frame_limit > 0 && frame_index >= frame_limit)) {
+        return false;
+    }
+    frame_index++;
+    return true;
+}
@@ -0,0 +1,249 @@
+#include "TrackerSession.h"
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+// stop() で実行中のタスクの終了を確かめる間隔
+const std::chrono::microseconds STOP_POLL(500);
+
+}
+
+TrackerSession::TrackerSession(std::string name, std::unique_ptr<FrameSource> frame_source,
+                               std::unique_ptr<KeyBackend> key_backend)
+    : session_name(std::move(name)), source(std::move(frame_source)),
+      command_mode_active(false), pool(nullptr), paced(false),
+      task_scheduled(false), tasks_in_flight(0), running(false), finished(false),
+      finished_at_ns(0) {
+    blink_detector = std::make_unique<BlinkDetector>();
+    gaze_estimator = std::make_unique<GazeEstimator>();
+    gaze_estimator->setMetrics(&metrics);
+    command_controller = std::make_unique<CommandController>(std::move(key_backend));
+    command_controller->getKeyInjector().setMetrics(&metrics);
+}
+
+TrackerSession::~TrackerSession() {
+    stop();
+}
+
+void TrackerSession::applyConfig(const EyeTrackingConfig& config) {
+    blink_detector->configure(config.blink);
+    gaze_estimator->configure(config.gaze);
+    command_controller->configure(config.gaze);
+}
+
+bool TrackerSession::start(WorkStealingPool& worker_pool) {
+    if (running || !source || !source->isOpened()) {
+        return false;
+    }
+    
+    pool = &worker_pool;
+    paced = source->isPaced();
+    finished = false;
+    started_at = Clock::now();
+    running = true;
+    
+    if (paced) {
+        frame_pool = std::make_unique<FramePool>(POOL_SIZE, source->frameSize());
+        capture_thread = std::thread(&TrackerSession::captureLoop, this);
+    } else {
+        read_packet = std::make_shared<FramePacket>();
+        schedule();
+    }
+    return true;
+}
+
+void TrackerSession::stop() {
+    running = false;
+    if (capture_thread.joinable()) {
+        capture_thread.join();
+    }
+    // 積まれたタスクは running を見て何もせずに終わる。プールより先に止めること
+    while (tasks_in_flight.load(std::memory_order_acquire) > 0) {
+        std::this_thread::sleep_for(STOP_POLL);
+    }
+    if (source) {
+        source->release();
+    }
+}
+
+double TrackerSession::elapsedSeconds() const {
+    if (isFinished()) {
+        return finished_at_ns.load(std::memory_order_relaxed) * 1e-9;
+    }
+    return std::chrono::duration<double>(Clock::now() - started_at).count();
+}
+
+void TrackerSession::captureLoop() {
+    while (running) {
+        FramePacketPtr packet = frame_pool->acquire();
+        if (!packet) {
+            // 全バッファが使用中: デバイスからは読み捨てて遅延の蓄積を防ぐ
+            if (!source->skip()) {
+                reportCaptureEnd();
+                break;
+            }
+            metrics.increment(MetricCounter::CaptureDropped);
+            continue;
+        }
+        
+        bool captured;
+        {
+            ScopedStageTimer timer(&metrics, MetricStage::CaptureWait);
+            captured = source->read(packet->frame, packet->capture_time);
+        }
+        if (!captured) {
+            reportCaptureEnd();
+            break;
+        }
+        packet->analysis.timestamp = packet->capture_time;
+        packet->analysis.capture_time = source->lastCaptureTime();
+        metrics.increment(MetricCounter::FramesCaptured);
+        
+        // 解析がまだ取っていない前のフレームは置き換える（最新のフレームだけを解析する）
+        FramePacketPtr replaced = std::atomic_exchange(&latest_frame, std::move(packet));
+        if (replaced) {
+            metrics.increment(MetricCounter::CaptureDropped);
+        }
+        schedule();
+    }
+    
+    // 再生の終端では、最後に置いたフレームが解析に渡ってから終了とする
+    while (running && std::atomic_load(&latest_frame)) {
+        std::this_thread::sleep_for(STOP_POLL);
+    }
+    markFinished();
+}
+
+void TrackerSession::reportCaptureEnd() {
+    // 記録済み入力の終端は正常な終了
+    if (source->isLive()) {
+        std::cerr << session_name << ": failed to capture frame" << std::endl;
+    }
+}
+
+void TrackerSession::schedule() {
+    // 解析タスクは1つだけ（実行中のタスクは終わるときに次のフレームを確かめる）
+    if (task_scheduled.exchange(true, std::memory_order_seq_cst)) {
+        return;
+    }
+    tasks_in_flight.fetch_add(1, std::memory_order_acq_rel);
+    scheduled_at = Clock::now();
+    pool->submit([this] { runTask(); });
+}
+
+void TrackerSession::runTask() {
+    metrics.record(MetricStage::PoolWait, Clock::now() - scheduled_at);
+    
+    FramePacketPtr packet;
+    if (running) {
+        if (paced) {
+            packet = std::atomic_exchange(&latest_frame, FramePacketPtr());
+        } else if (!readRecordedFrame(packet)) {
+            markFinished();
+        }
+    }
+    
+    if (packet) {
+        processFrame(*packet);
+        metrics.increment(MetricCounter::FramesAnalyzed);
+        metrics.record(MetricStage::CaptureToAnalysis, Clock::now() - packet->analysis.capture_time);
+        packet.reset();
+    }
+    
+    // 取得スレッドの「latest_frame を置く → task_scheduled を見る」と、ここの「task_scheduled を下ろす →
+    // latest_frame を見る」は、どちらも seq_cst でないと互いの書き込みを見落として最後のフレームが残る
+    task_scheduled.store(false, std::memory_order_seq_cst);
+    // 待たない記録済み入力は終端まで続けて読む。待つ入力は解析中に次のフレームが届いていれば続ける
+    // （1回のタスクで1フレームだけ処理し、他のセッションのタスクの後ろに並び直す）
+    if (running && !isFinished() && (!paced || std::atomic_load(&latest_frame))) {
+        schedule();
+    }
+    // この後 this に触れない（stop() が待っているのはこのカウントだけ）
+    tasks_in_flight.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+bool TrackerSession::readRecordedFrame(FramePacketPtr& packet) {
+    bool captured;
+    {
+        ScopedStageTimer timer(&metrics, MetricStage::CaptureWait);
+        captured = source->read(read_packet->frame, read_packet->capture_time);
+    }
+    if (!captured) {
+        return false;
+    }
+    read_packet->analysis = FrameAnalysis();
+    read_packet->analysis.timestamp = read_packet->capture_time;
+    read_packet->analysis.capture_time = source->lastCaptureTime();
+    metrics.increment(MetricCounter::FramesCaptured);
+    packet = read_packet;
+    return true;
+}
+
+void TrackerSession::processFrame(FramePacket& packet) {
+    // EyeTracker::processFrame と同じ順に、1フレームの解析を1回だけ行う
+    const cv::Mat& eye_roi = packet.frame;
+    FrameAnalysis& analysis = packet.analysis;
+    
+    preprocess_cache.reset(eye_roi);
+    {
+        ScopedStageTimer timer(&metrics, MetricStage::PupilTrack);
+        analysis.pupil_center = pupil_tracker.track(preprocess_cache, analysis.timestamp, *gaze_estimator);
+    }
+    analysis.pupil_found = analysis.pupil_center.x >= 0 && analysis.pupil_center.y >= 0;
+    analysis.pupil_track_state = pupil_tracker.state();
+    analysis.pupil_window_confirmed = pupil_tracker.confirmedByWindow();
+    if (!analysis.pupil_found) {
+        metrics.increment(MetricCounter::PupilLost);
+    }
+    {
+        ScopedStageTimer timer(&metrics, MetricStage::Ear);
+        analysis.ear = blink_detector->calculateOpenness(preprocess_cache);
+    }
+    
+    // ダブル瞬きでコマンドモードを切り替える
+    blink_detector->detectBlink(analysis);
+    if (analysis.double_blink) {
+        if (!command_mode_active) {
+            command_controller->activateCommandMode(analysis.timestamp);
+            command_mode_active = true;
+            std::cout << session_name << ": command mode activated" << std::endl;
+        } else {
+            command_controller->deactivateCommandMode();
+            command_mode_active = false;
+            std::cout << session_name << ": command mode deactivated" << std::endl;
+        }
+    }
+    
+    // コマンドモード中で未キャリブレーションなら現在の瞳孔位置を基準にする
+    if (command_mode_active && !gaze_estimator->isCalibrated()) {
+        gaze_estimator->calibrateBaseline(analysis.pupil_center, eye_roi.size());
+    }
+    
+    {
+        ScopedStageTimer timer(&metrics, MetricStage::Gaze);
+        analysis.gaze_direction = gaze_estimator->calculateGazeDirection(analysis.pupil_center);
+    }
+    
+    if (command_mode_active && gaze_estimator->isCalibrated()) {
+        const cv::Point2f& direction = analysis.gaze_direction;
+        double magnitude = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+        if (magnitude > 0.3) {
+            ScopedStageTimer timer(&metrics, MetricStage::CommandDispatch);
+            if (command_controller->executeDirectionCommand(analysis)) {
+                metrics.increment(MetricCounter::CommandsSent);
+            }
+        }
+        if (!command_controller->isCommandModeActive(analysis.timestamp)) {
+            command_mode_active = false;
+        }
+    }
+    
+    analysis.command_active = command_mode_active;
+}
+
+void TrackerSession::markFinished() {
+    finished_at_ns.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - started_at).count(), std::memory_order_relaxed);
+    finished.store(true, std::memory_order_release);
+}
@@ -1,10 +1,12 @@
 #include "Utils.h"
+#include "Config.h"
 #include <iostream>
 #include <fstream>
 #include <chrono>
 
 std::chrono::steady_clock::time_point Utils::last_time = std::chrono::steady_clock::now();
 int Utils::frame_count = 0;
+double Utils::last_fps = 0.0;
 
 std::string Utils::getConfigPath() {
 #ifdef _WIN32
@@ -30,14 +32,19 @@ std::string Utils::getDataPath() {
 #endif
 }
 
-bool Utils::loadConfig(const std::string& config_path) {
-    std::ifstream file(config_path);
-    if (file.is_open()) {
-        std::cout << "Config loaded from: " << config_path << std::endl;
-        file.close();
-        return true;
+bool Utils::loadConfig(const std::string& config_path, EyeTrackingConfig& config) {
+    std::string error;
+    std::vector<std::string> warnings;
+    if (!ConfigLoader::load(config_path, config, error, &warnings)) {
+        std::cerr << "Config: " << error << std::endl;
+        return false;
     }
-    return false;
+    
+    for (const auto& warning : warnings) {
+        std::cerr << "Config: " << warning << std::endl;
+    }
+    std::cout << "Config loaded from: " << config_path << std::endl;
+    return true;
 }
 
 void Utils::saveCalibrationData(const std::string& filename, 
@@ -64,15 +71,25 @@ cv::Point2f Utils::loadCalibrationData(const std::string& filename) {
     return baseline;
 }
 
-void Utils::drawDebugInfo(cv::Mat& frame, 
-                         const cv::Point2f& pupil_pos,
-                         const cv::Point2f& gaze_direction,
-                         bool command_active) {
+void Utils::drawDebugInfo(cv::Mat& frame, const FrameAnalysis& analysis) {
+    const cv::Point2f& gaze_direction = analysis.gaze_direction;
+    bool command_active = analysis.command_active;
+    
     // 瞳孔位置を描画
-    if (pupil_pos.x >= 0 && pupil_pos.y >= 0) {
-        cv::circle(frame, pupil_pos, 3, cv::Scalar(0, 255, 0), -1);
+    if (analysis.pupil_found) {
+        cv::circle(frame, analysis.pupil_center, 3, cv::Scalar(0, 255, 0), -1);
     }
     
+    // 瞳孔の追跡状態を表示
+    const char* track_text = "LOST";
+    if (analysis.pupil_track_state == PupilTrackState::Confirmed) {
+        track_text = "TRACKING";
+    } else if (analysis.pupil_track_state == PupilTrackState::Predicted) {
+        track_text = "PREDICTED";
+    }
+    cv::putText(frame, track_text, cv::Point(10, 60), 
+                cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 255, 255), 1);
+    
     // 視線方向を矢印で描画
     if (gaze_direction.x != 0 || gaze_direction.y != 0) {
         cv::Point2f center(frame.cols / 2, frame.rows / 2);
@@ -80,6 +97,14 @@ void Utils::drawDebugInfo(cv::Mat& frame,
         cv::arrowedLine(frame, center, end_point, cv::Scalar(255, 0, 0), 2);
     }
     
+    // キャリブレーションの目標を表示（プレビュー画面を画面全体に見立てる）
+    if (analysis.calibrating) {
+        cv::Point target(cvRound((analysis.calibration_target.x + 1.0f) * 0.5f * (frame.cols - 1)),
+                         cvRound((analysis.calibration_target.y + 1.0f) * 0.5f * (frame.rows - 1)));
+        cv::circle(frame, target, 12, cv::Scalar(0, 255, 255), 2);
+        cv::circle(frame, target, 3, cv::Scalar(0, 255, 255), -1);
+    }
+    
     // コマンドモード状態を表示
     std::string mode_text = command_active ? "COMMAND ACTIVE" : "MONITORING";
     cv::Scalar text_color = command_active ? cv::Scalar(0, 0, 255) : cv::Scalar(255, 255, 255);
@@ -101,11 +126,11 @@ double Utils::calculateFPS() {
         current_time - last_time);
     
     if (duration.count() >= 1000) { // 1秒経過
-        double fps = frame_count * 1000.0 / duration.count();
+        last_fps = frame_count * 1000.0 / duration.count();
         frame_count = 0;
         last_time = current_time;
-        return fps;
     }
     
-    return 0.0;
+    // 1秒ごとに測った値を次の計測まで返し続ける（表示が 0 とちらつかないように）
+    return last_fps;
 }
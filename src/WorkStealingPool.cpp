@@ -0,0 +1,101 @@
+#include "WorkStealingPool.h"
+#include <algorithm>
+
+namespace {
+
+// 実行中のワーカーの所属（ワーカーの中からの submit を自分のキューに積むため）
+thread_local const WorkStealingPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+
+}
+
+WorkStealingPool::WorkStealingPool(size_t thread_count)
+    : running(true), queued(0), next_queue(0), executed_count(0), stolen_count(0) {
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    
+    for (size_t i = 0; i < thread_count; i++) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    // キューを全て作ってから起動する（起動直後のワーカーが他のキューを覗くため）
+    for (size_t i = 0; i < thread_count; i++) {
+        threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        running = false;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::submit(Task task) {
+    size_t index = current_pool == this
+        ? current_worker
+        : next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    queued.fetch_add(1, std::memory_order_release);
+    
+    // 待機に入る直前の通知を取りこぼさないよう、mutex を一瞬だけ通す
+    { std::lock_guard<std::mutex> lock(wake_mutex); }
+    wake.notify_one();
+}
+
+void WorkStealingPool::workerLoop(size_t index) {
+    current_pool = this;
+    current_worker = index;
+    Task task;
+    
+    while (true) {
+        if (takeTask(index, task)) {
+            task();
+            task = nullptr;
+            executed_count.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        // 停止は積まれたタスクがなくなってから（呼び出し側が新しいタスクを積まなくなっている前提）
+        if (!running && queued.load(std::memory_order_acquire) == 0) {
+            break;
+        }
+        wake.wait(lock, [this] { return !running || queued.load(std::memory_order_acquire) > 0; });
+    }
+    
+    current_pool = nullptr;
+}
+
+bool WorkStealingPool::takeTask(size_t index, Task& task) {
+    if (popFront(*queues[index], task)) {
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    // 自分のキューが空なら、隣のワーカーから順に取りに行く
+    for (size_t n = 1; n < queues.size(); n++) {
+        if (popFront(*queues[(index + n) % queues.size()], task)) {
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            stolen_count.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WorkStealingPool::popFront(WorkerQueue& queue, Task& task) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    return true;
+}
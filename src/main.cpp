@@ -1,28 +1,278 @@
 #include "EyeTracker.h"
+#include "MultiStreamTracker.h"
 #include "Utils.h"
+#include "SyntheticEyeGenerator.h"
+#include <algorithm>
+#include <csignal>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <string>
 
-int main() {
+namespace {
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [--camera <id>] [--replay <video|image_dir> [--fast]] [--synthetic <frames>] [--pointer|--pointer-headless] [--config <path>] [--user <name>] [--metrics <path>|--no-metrics] [--latency-test] [--headless|--preview <fps>] [--streams <spec,...> [--workers <n>]]" << std::endl;
+    std::cout << "  --camera <id>     use a live camera (default: 0)" << std::endl;
+    std::cout << "  --config <path>   config file to load and watch for changes" << std::endl;
+    std::cout << "  --user <name>     calibration profile to use (default: default)" << std::endl;
+    std::cout << "  --calibrate <5|9>  run a 5- or 9-point gaze calibration at startup ('c' key: 9-point)" << std::endl;
+    std::cout << "  --calibration <path>  calibration profile store (default: data/calibration/profiles.bin)" << std::endl;
+    std::cout << "  --replay <path>   replay a recorded video file or numbered image directory" << std::endl;
+    std::cout << "  --fast            replay as fast as possible instead of at the recorded rate" << std::endl;
+    std::cout << "  --synthetic <n>   feed n generated eye frames (0 = endless)" << std::endl;
+    std::cout << "  --pointer         move the mouse cursor continuously with gaze" << std::endl;
+    std::cout << "  --pointer-headless  run pointer mode without touching the real cursor" << std::endl;
+    std::cout << "  --metrics <path>  write stage latencies and counters at exit and on 'm' (.csv or Prometheus text; not written by default)" << std::endl;
+    std::cout << "  --no-metrics      disable stage latency measurement" << std::endl;
+    std::cout << "  --headless        run without any rendering or window (stop with Ctrl+C / SIGTERM)" << std::endl;
+    std::cout << "  --preview <fps>   render the debug overlay at most fps times per second (latest result only)" << std::endl;
+    std::cout << "  --streams <spec,...>  track several streams at once, headless (spec: camera id, 'synthetic' or a replay path)" << std::endl;
+    std::cout << "  --workers <n>     worker threads shared by --streams (default: core count)" << std::endl;
+    std::cout << "  --latency-test    keep command mode on, record keys instead of sending them and report capture-to-key latency" << std::endl;
+}
+
+// シグナルで停止を求める実行中のトラッカー（ヘッドレスではウィンドウの ESC が使えないため）
+EyeTracker* running_tracker = nullptr;
+MultiStreamTracker* running_streams = nullptr;
+
+void handleStopSignal(int) {
+    if (running_tracker) {
+        running_tracker->requestStop();
+    }
+    if (running_streams) {
+        running_streams->requestStop();
+    }
+}
+
+// --streams の各要素から入力を開く（数字はカメラ番号、synthetic は合成映像、それ以外は再生）
+std::unique_ptr<FrameSource> openStream(const std::string& spec, size_t index, const EyeTrackingConfig& config,
+                                        long long synthetic_frames, ReplayPacing pacing) {
+    if (!spec.empty() && spec.find_first_not_of("0123456789") == std::string::npos) {
+        auto camera = std::make_unique<CameraSource>();
+        if (!camera->open(std::stoi(spec), config.camera.width, config.camera.height, config.camera.fps)) {
+            return nullptr;
+        }
+        return camera;
+    }
+    if (spec == "synthetic") {
+        return std::make_unique<SyntheticEyeSource>(cv::Size(640, 480), 30.0,
+            static_cast<uint64_t>(std::max(0LL, synthetic_frames)), 0x5eed + index);
+    }
+    auto replay = std::make_unique<ReplaySource>();
+    if (!replay->open(spec, pacing)) {
+        return nullptr;
+    }
+    return replay;
+}
+
+int runStreams(const std::string& specs, size_t workers, const EyeTrackingConfig& config,
+               long long synthetic_frames, ReplayPacing pacing) {
+    // フレームの並列化はプールで行うため、OpenCV 内部の並列化は止める（コアの奪い合いを避ける）
+    cv::setNumThreads(1);
+    
+    MultiStreamTracker streams(workers);
+    streams.applyConfig(config);
+    size_t index = 0;
+    for (size_t begin = 0; begin < specs.size(); index++) {
+        size_t end = specs.find(',', begin);
+        std::string spec = specs.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+        begin = end == std::string::npos ? specs.size() : end + 1;
+        
+        std::unique_ptr<FrameSource> source = openStream(spec, index, config, synthetic_frames, pacing);
+        if (!source) {
+            std::cerr << "Failed to open stream " << spec << std::endl;
+            return -1;
+        }
+        // 記録済み・合成の入力からは実際のキーを送らない
+        std::unique_ptr<KeyBackend> keys;
+        if (!source->isLive()) {
+            keys = std::make_unique<RecordingKeyBackend>();
+        }
+        streams.addSession(spec + "#" + std::to_string(index), std::move(source), std::move(keys));
+    }
+    
+    std::cout << "Tracking " << streams.sessionCount() << " streams, press Ctrl+C to exit" << std::endl;
+    running_streams = &streams;
+    std::signal(SIGINT, handleStopSignal);
+    std::signal(SIGTERM, handleStopSignal);
+    streams.run();
+    running_streams = nullptr;
+    
+    MultiStreamTracker::printReport(streams.report(), std::cout);
+    return 0;
+}
+
+void printLatencyReport(const PipelineMetrics& metrics) {
+    const MetricStage stages[] = {
+        MetricStage::CaptureToAnalysis, MetricStage::CommandDispatch,
+        MetricStage::KeyQueue, MetricStage::CaptureToKey
+    };
+    
+    std::cout << "Latency (ms)          count      p50      p90      p99      max" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    for (MetricStage stage : stages) {
+        LatencyHistogram::Snapshot snap = metrics.stageSnapshot(stage);
+        std::cout << std::left << std::setw(20) << PipelineMetrics::stageName(stage) << std::right
+                  << std::setw(8) << snap.count
+                  << std::setw(9) << snap.percentileNs(0.5) * 1e-6
+                  << std::setw(9) << snap.percentileNs(0.9) * 1e-6
+                  << std::setw(9) << snap.percentileNs(0.99) * 1e-6
+                  << std::setw(9) << snap.max_ns * 1e-6 << std::endl;
+    }
+    std::cout << std::defaultfloat;
+    std::cout << "Keys pressed: " << metrics.counterValue(MetricCounter::KeysPressed)
+              << " (commands: " << metrics.counterValue(MetricCounter::CommandsSent) << ")" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv) {
+    int camera_id = 0;
+    std::string replay_path;
+    ReplayPacing pacing = ReplayPacing::Realtime;
+    long long synthetic_frames = -1;
+    bool pointer_mode = false;
+    bool pointer_headless = false;
+    std::string config_path;
+    std::string user = "default";
+    int calibration_points = 0;
+    std::string calibration_path = Utils::getDataPath() + "calibration/profiles.bin";
+    std::string metrics_path; // 空なら書き出さない
+    bool metrics_enabled = true;
+    bool latency_test = false;
+    DisplayMode display_mode = DisplayMode::Window;
+    double preview_fps = 10.0;
+    std::string stream_specs;
+    size_t workers = 0;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--camera" && i + 1 < argc) {
+            camera_id = std::stoi(argv[++i]);
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (arg == "--synthetic" && i + 1 < argc) {
+            synthetic_frames = std::stoll(argv[++i]);
+        } else if (arg == "--config" && i + 1 < argc) {
+            config_path = argv[++i];
+        } else if (arg == "--user" && i + 1 < argc) {
+            user = argv[++i];
+        } else if (arg == "--calibration" && i + 1 < argc) {
+            calibration_path = argv[++i];
+        } else if (arg == "--calibrate" && i + 1 < argc) {
+            calibration_points = std::stoi(argv[++i]);
+        } else if (arg == "--metrics" && i + 1 < argc) {
+            metrics_path = argv[++i];
+        } else if (arg == "--no-metrics") {
+            metrics_enabled = false;
+        } else if (arg == "--headless") {
+            display_mode = DisplayMode::Headless;
+        } else if (arg == "--preview" && i + 1 < argc) {
+            display_mode = DisplayMode::Preview;
+            preview_fps = std::stod(argv[++i]);
+        } else if (arg == "--streams" && i + 1 < argc) {
+            stream_specs = argv[++i];
+        } else if (arg == "--workers" && i + 1 < argc) {
+            workers = static_cast<size_t>(std::max(0, std::stoi(argv[++i])));
+        } else if (arg == "--latency-test") {
+            latency_test = true;
+        } else if (arg == "--pointer") {
+            pointer_mode = true;
+        } else if (arg == "--pointer-headless") {
+            pointer_mode = true;
+            pointer_headless = true;
+        } else if (arg == "--fast") {
+            pacing = ReplayPacing::AsFastAsPossible;
+        } else {
+            printUsage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : -1;
+        }
+    }
+    
     std::cout << "Eye Tracking System Starting..." << std::endl;
     
-    // 設定ファイルの読み込み
-    if (!Utils::loadConfig(Utils::getConfigPath())) {
+    // 設定ファイルの読み込み（ユーザー設定がなければ実行ディレクトリの config.xml）
+    if (config_path.empty()) {
+        config_path = std::ifstream(Utils::getConfigPath()).is_open() ? Utils::getConfigPath() : "config.xml";
+    }
+    EyeTrackingConfig config;
+    if (!Utils::loadConfig(config_path, config)) {
         std::cout << "Warning: Could not load config file, using defaults" << std::endl;
     }
     
+    if (!stream_specs.empty()) {
+        return runStreams(stream_specs, workers, config, synthetic_frames, pacing);
+    }
+    
     // EyeTrackerの初期化
     EyeTracker tracker;
-    if (!tracker.initialize(0)) {
+    tracker.applyConfig(config);
+    tracker.getMetrics().setEnabled(metrics_enabled);
+    tracker.setMetricsOutput(metrics_path);
+    // 保存済みのプロファイルがあれば較正済みで始める（壊れていれば較正し直して上書きする）
+    if (!tracker.openCalibrationStore(calibration_path, user)) {
+        std::cout << "Warning: Could not read calibration store, calibrating from scratch" << std::endl;
+    }
+    // 実行中の変更も反映する（キオスク端末などで再起動せずに閾値を調整するため）
+    // プロファイルを反映した後の設定から監視を始める
+    tracker.watchConfig(config_path);
+    bool initialized = false;
+    if (synthetic_frames >= 0) {
+        initialized = tracker.initialize(std::make_unique<SyntheticEyeSource>(
+            cv::Size(640, 480), 30.0, static_cast<uint64_t>(synthetic_frames)));
+    } else if (!replay_path.empty()) {
+        initialized = tracker.initialize(replay_path, pacing);
+    } else {
+        initialized = tracker.initialize(camera_id);
+    }
+    if (!initialized) {
         std::cerr << "Failed to initialize eye tracker" << std::endl;
         return -1;
     }
     
+    if (pointer_mode) {
+        std::unique_ptr<CursorBackend> cursor_backend;
+        if (pointer_headless) {
+            cursor_backend = std::make_unique<RecordingCursorBackend>();
+        }
+        if (!tracker.enablePointerMode(std::move(cursor_backend))) {
+            return -1;
+        }
+    }
+    
+    if (latency_test) {
+        // 遅延は処理時間の計測値に記録するため、--no-metrics より優先する
+        tracker.getMetrics().setEnabled(true);
+        tracker.enableLatencyTest();
+    }
+    
+    tracker.setDisplayMode(display_mode, preview_fps);
+    
     std::cout << "Eye tracker initialized successfully" << std::endl;
     std::cout << "Double blink to activate command mode" << std::endl;
-    std::cout << "Press ESC to exit" << std::endl;
+    std::cout << (display_mode == DisplayMode::Headless ? "Press Ctrl+C to exit" : "Press ESC to exit") << std::endl;
+    
+    if (calibration_points > 0) {
+        tracker.startGazeCalibration(calibration_points);
+    }
     
     // メインループ実行
+    running_tracker = &tracker;
+    std::signal(SIGINT, handleStopSignal);
+    std::signal(SIGTERM, handleStopSignal);
     tracker.run();
+    running_tracker = nullptr;
+    
+    if (GazeCursor* cursor = tracker.getGazeCursor()) {
+        std::cout << "Pointer (" << cursor->backendName() << "): " << cursor->updateCount()
+                  << " gaze updates, " << cursor->tickCount() << " output ticks, "
+                  << cursor->moveCount() << " cursor moves" << std::endl;
+    }
+    
+    if (latency_test) {
+        printLatencyReport(tracker.getMetrics());
+    }
     
     std::cout << "Eye tracking system stopped" << std::endl;
     return 0;
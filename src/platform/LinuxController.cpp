@@ -0,0 +1,74 @@
+#include "PlatformController.h"
+
+#ifdef __linux__
+
+#ifdef EYE_TRACKER_HAVE_XTEST
+#include <X11/Xlib.h>
+#include <X11/extensions/XTest.h>
+#include <mutex>
+
+namespace {
+
+// 呼び出しごとに XOpenDisplay しないよう、接続は最初の呼び出しで開いて使い回す
+// 画面サイズは解析側のスレッドから、カーソル移動は GazeCursor の出力スレッドから呼ばれる。
+// XInitThreads() なしの Xlib は1つの接続を同時に使えないので、接続を使う間は display_mutex を持つ
+std::mutex display_mutex;
+
+Display* sharedDisplay() {
+    static Display* display = XOpenDisplay(nullptr);
+    return display;
+}
+
+}
+
+void PlatformController::sendKeyPress(int key_code) {
+    std::lock_guard<std::mutex> lock(display_mutex);
+    Display* display = sharedDisplay();
+    if (!display) {
+        return;
+    }
+    KeyCode keycode = XKeysymToKeycode(display, key_code);
+    XTestFakeKeyEvent(display, keycode, True, CurrentTime);
+    // 解放は X サーバ側で 50ms 遅らせる（呼び出し元は待たない）
+    XTestFakeKeyEvent(display, keycode, False, 50);
+    XFlush(display);
+}
+
+void PlatformController::moveMouse(int x, int y) {
+    std::lock_guard<std::mutex> lock(display_mutex);
+    Display* display = sharedDisplay();
+    if (!display) {
+        return;
+    }
+    XTestFakeMotionEvent(display, -1, x, y, CurrentTime);
+    XFlush(display);
+}
+
+bool PlatformController::getScreenSize(int& width, int& height) {
+    std::lock_guard<std::mutex> lock(display_mutex);
+    Display* display = sharedDisplay();
+    if (!display) {
+        return false;
+    }
+    Screen* screen = DefaultScreenOfDisplay(display);
+    width = WidthOfScreen(screen);
+    height = HeightOfScreen(screen);
+    return width > 0 && height > 0;
+}
+
+#else
+
+// XTest なしでビルドした場合は何もしない（GazeCursor は画面サイズが取れないので開始しない）
+void PlatformController::sendKeyPress(int) {
+}
+
+void PlatformController::moveMouse(int, int) {
+}
+
+bool PlatformController::getScreenSize(int&, int&) {
+    return false;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,102 @@
+#include "KeyBackend.h"
+
+#ifdef __linux__
+#include <cstring>
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace {
+
+const int UINPUT_KEYS[] = { KEY_UP, KEY_DOWN, KEY_LEFT, KEY_RIGHT };
+
+// /dev/uinput に仮想キーボードを作る（X がない環境や Wayland 向け）
+// デバイスは open() で1回だけ作成し、close() まで使い回す
+class UinputKeyBackend : public KeyBackend {
+private:
+    int fd = -1;
+    
+    int keycode(InjectedKey key) const {
+        switch (key) {
+            case InjectedKey::Up:    return KEY_UP;
+            case InjectedKey::Down:  return KEY_DOWN;
+            case InjectedKey::Left:  return KEY_LEFT;
+            case InjectedKey::Right: return KEY_RIGHT;
+        }
+        return KEY_UP;
+    }
+    
+    void emit(int type, int code, int value) {
+        struct input_event event;
+        memset(&event, 0, sizeof(event));
+        event.type = type;
+        event.code = code;
+        event.value = value;
+        if (write(fd, &event, sizeof(event)) < 0) {
+            // 書き込み失敗は次のキーで再試行されるので無視する
+        }
+    }
+    
+    void sendEvent(InjectedKey key, bool pressed) {
+        if (fd < 0) {
+            return;
+        }
+        emit(EV_KEY, keycode(key), pressed ? 1 : 0);
+        emit(EV_SYN, SYN_REPORT, 0);
+    }
+
+public:
+    ~UinputKeyBackend() override { close(); }
+    
+    bool open() override {
+        if (fd >= 0) {
+            return true;
+        }
+        fd = ::open("/dev/uinput", O_WRONLY | O_NONBLOCK);
+        if (fd < 0) {
+            return false;
+        }
+        
+        bool ok = ioctl(fd, UI_SET_EVBIT, EV_KEY) >= 0;
+        for (int code : UINPUT_KEYS) {
+            ok = ok && ioctl(fd, UI_SET_KEYBIT, code) >= 0;
+        }
+        
+        struct uinput_setup setup;
+        memset(&setup, 0, sizeof(setup));
+        setup.id.bustype = BUS_VIRTUAL;
+        setup.id.vendor = 0x1209;
+        setup.id.product = 0x0001;
+        strncpy(setup.name, "eye-tracker virtual keyboard", UINPUT_MAX_NAME_SIZE - 1);
+        ok = ok && ioctl(fd, UI_DEV_SETUP, &setup) >= 0;
+        ok = ok && ioctl(fd, UI_DEV_CREATE) >= 0;
+        
+        if (!ok) {
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+        return true;
+    }
+    
+    void close() override {
+        if (fd >= 0) {
+            ioctl(fd, UI_DEV_DESTROY);
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    
+    void press(InjectedKey key) override { sendEvent(key, true); }
+    void release(InjectedKey key) override { sendEvent(key, false); }
+    const char* name() const override { return "uinput"; }
+};
+
+}
+
+std::unique_ptr<KeyBackend> createUinputKeyBackend() {
+    return std::make_unique<UinputKeyBackend>();
+}
+
+#endif
@@ -13,4 +13,10 @@ void PlatformController::moveMouse(int x, int y) {
     SetCursorPos(x, y);
 }
 
+bool PlatformController::getScreenSize(int& width, int& height) {
+    width = GetSystemMetrics(SM_CXSCREEN);
+    height = GetSystemMetrics(SM_CYSCREEN);
+    return width > 0 && height > 0;
+}
+
 #endif
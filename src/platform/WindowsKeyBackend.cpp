@@ -0,0 +1,44 @@
+#include "KeyBackend.h"
+
+#ifdef _WIN32
+#include <windows.h>
+
+namespace {
+
+// SendInput で押下・解放を1イベントずつ送る（待ち時間は KeyInjector のタイマーが持つ）
+class WindowsKeyBackend : public KeyBackend {
+private:
+    WORD virtualKey(InjectedKey key) const {
+        switch (key) {
+            case InjectedKey::Up:    return VK_UP;
+            case InjectedKey::Down:  return VK_DOWN;
+            case InjectedKey::Left:  return VK_LEFT;
+            case InjectedKey::Right: return VK_RIGHT;
+        }
+        return VK_UP;
+    }
+    
+    void sendEvent(InjectedKey key, bool pressed) {
+        INPUT input = {};
+        input.type = INPUT_KEYBOARD;
+        input.ki.wVk = virtualKey(key);
+        // 矢印キーは拡張キー
+        input.ki.dwFlags = KEYEVENTF_EXTENDEDKEY | (pressed ? 0 : KEYEVENTF_KEYUP);
+        SendInput(1, &input, sizeof(INPUT));
+    }
+
+public:
+    bool open() override { return true; }
+    void close() override {}
+    void press(InjectedKey key) override { sendEvent(key, true); }
+    void release(InjectedKey key) override { sendEvent(key, false); }
+    const char* name() const override { return "sendinput"; }
+};
+
+}
+
+std::unique_ptr<KeyBackend> createWindowsKeyBackend() {
+    return std::make_unique<WindowsKeyBackend>();
+}
+
+#endif
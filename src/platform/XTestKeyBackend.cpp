@@ -0,0 +1,73 @@
+#include "KeyBackend.h"
+
+#ifdef EYE_TRACKER_HAVE_XTEST
+#include <X11/Xlib.h>
+#include <X11/extensions/XTest.h>
+#include <X11/keysym.h>
+
+namespace {
+
+// X サーバへの接続を開いたまま保持し、キーごとの XOpenDisplay を避ける
+// 接続は KeyInjector のスレッドからしか触らないため XInitThreads は不要
+class XTestKeyBackend : public KeyBackend {
+private:
+    Display* display = nullptr;
+    
+    KeyCode keycode(InjectedKey key) const {
+        KeySym keysym = XK_Up;
+        switch (key) {
+            case InjectedKey::Up:    keysym = XK_Up; break;
+            case InjectedKey::Down:  keysym = XK_Down; break;
+            case InjectedKey::Left:  keysym = XK_Left; break;
+            case InjectedKey::Right: keysym = XK_Right; break;
+        }
+        return XKeysymToKeycode(display, keysym);
+    }
+    
+    void sendEvent(InjectedKey key, bool pressed) {
+        if (!display) {
+            return;
+        }
+        XTestFakeKeyEvent(display, keycode(key), pressed ? True : False, CurrentTime);
+        XFlush(display);
+    }
+
+public:
+    ~XTestKeyBackend() override { close(); }
+    
+    bool open() override {
+        if (display) {
+            return true;
+        }
+        display = XOpenDisplay(nullptr);
+        if (!display) {
+            return false;
+        }
+        
+        int event_base, error_base, major, minor;
+        if (!XTestQueryExtension(display, &event_base, &error_base, &major, &minor)) {
+            close();
+            return false;
+        }
+        return true;
+    }
+    
+    void close() override {
+        if (display) {
+            XCloseDisplay(display);
+            display = nullptr;
+        }
+    }
+    
+    void press(InjectedKey key) override { sendEvent(key, true); }
+    void release(InjectedKey key) override { sendEvent(key, false); }
+    const char* name() const override { return "xtest"; }
+};
+
+}
+
+std::unique_ptr<KeyBackend> createXTestKeyBackend() {
+    return std::make_unique<XTestKeyBackend>();
+}
+
+#endif
@@ -0,0 +1,129 @@
+// KeyInjector の押下・解放の順序と押下時間を記録バックエンドで確かめる
+// 失敗した項目を標準エラーに出し、1つでも失敗すれば 1 を返す
+#include "KeyInjector.h"
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const std::chrono::milliseconds HOLD(50);
+// スレッドの起床の遅れとして許す幅（負荷の高い CI でも落ちないよう大きめ）
+const std::chrono::milliseconds SLACK(40);
+
+int failures = 0;
+
+void check(bool condition, const char* test, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL " << test << ": " << what << std::endl;
+        failures++;
+    }
+}
+
+double toMs(Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+// 押下と解放が交互に並び、それぞれ HOLD 以上押されていることを確かめる
+void checkAlternating(const char* test, const std::vector<RecordedKeyEvent>& events, InjectedKey key) {
+    check(events.size() % 2 == 0, test, "press/release count mismatch: " + std::to_string(events.size()) + " events");
+    for (size_t i = 0; i < events.size(); i++) {
+        check(events[i].key == key, test, "unexpected key at event " + std::to_string(i));
+        check(events[i].pressed == (i % 2 == 0), test, "press/release out of order at event " + std::to_string(i));
+        
+        if (i % 2 == 1) {
+            Clock::duration held = events[i].time - events[i - 1].time;
+            check(held >= HOLD, test, "released after " + std::to_string(toMs(held)) + " ms");
+            check(held < HOLD + SLACK, test, "held for " + std::to_string(toMs(held)) + " ms");
+        }
+    }
+}
+
+// 1回の送信: 押下して HOLD 後に解放する
+void testSinglePress() {
+    auto recorder = std::make_unique<RecordingKeyBackend>();
+    RecordingKeyBackend* backend = recorder.get();
+    KeyInjector injector(std::move(recorder), HOLD);
+    check(injector.start(), "single", "start failed");
+    
+    injector.send(InjectedKey::Up);
+    std::this_thread::sleep_for(HOLD * 3);
+    
+    std::vector<RecordedKeyEvent> events = backend->events();
+    check(events.size() == 2, "single", "expected 2 events, got " + std::to_string(events.size()));
+    checkAlternating("single", events, InjectedKey::Up);
+    check(injector.sentCount() == 1, "single", "sent count " + std::to_string(injector.sentCount()));
+    
+    injector.stop();
+    check(!backend->isOpened(), "single", "backend left open after stop");
+}
+
+// 視線を保ったまま毎フレーム（30 fps）同じキーを送る: 押しっぱなしにならず、HOLD ごとに押し直す
+void testSustainedRepeat() {
+    auto recorder = std::make_unique<RecordingKeyBackend>();
+    RecordingKeyBackend* backend = recorder.get();
+    KeyInjector injector(std::move(recorder), HOLD);
+    check(injector.start(), "repeat", "start failed");
+    
+    const int FRAMES = 15;
+    const std::chrono::milliseconds FRAME_INTERVAL(33);
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < FRAMES; i++) {
+        std::this_thread::sleep_until(start + FRAME_INTERVAL * i);
+        injector.send(InjectedKey::Right);
+    }
+    std::this_thread::sleep_for(HOLD * 4);
+    injector.stop();
+    
+    std::vector<RecordedKeyEvent> events = backend->events();
+    checkAlternating("repeat", events, InjectedKey::Right);
+    
+    // 約 500 ms の間に HOLD ごとの押下がほぼ続く（押しっぱなし1回ではない）
+    size_t presses = events.size() / 2;
+    check(presses >= 5, "repeat", "only " + std::to_string(presses) + " presses for " + std::to_string(FRAMES) + " frames");
+    // 送信数・まとめた数は、バックエンドに届いた押下と一致する
+    check(injector.sentCount() == presses, "repeat",
+          "sent count " + std::to_string(injector.sentCount()) + " != presses " + std::to_string(presses));
+    check(injector.sentCount() + injector.mergedCount() + injector.droppedCount() == static_cast<uint64_t>(FRAMES),
+          "repeat", "sent + merged + dropped != commands");
+}
+
+// 押下中に止めたら、解放してから止まる
+void testStopReleasesHeldKey() {
+    auto recorder = std::make_unique<RecordingKeyBackend>();
+    RecordingKeyBackend* backend = recorder.get();
+    KeyInjector injector(std::move(recorder), std::chrono::milliseconds(10000));
+    check(injector.start(), "stop", "start failed");
+    
+    injector.send(InjectedKey::Left);
+    injector.send(InjectedKey::Down);
+    injector.stop();
+    
+    std::vector<RecordedKeyEvent> events = backend->events();
+    check(events.size() == 4, "stop", "expected 4 events, got " + std::to_string(events.size()));
+    if (events.size() == 4) {
+        check(events[0].pressed && events[0].key == InjectedKey::Left, "stop", "first event is not Left press");
+        check(events[1].pressed && events[1].key == InjectedKey::Down, "stop", "second event is not Down press");
+        check(!events[2].pressed && !events[3].pressed, "stop", "keys not released on stop");
+    }
+}
+
+}
+
+int main() {
+    testSinglePress();
+    testSustainedRepeat();
+    testStopReleasesHeldKey();
+    
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "key_injector_test: all checks passed" << std::endl;
+    return 0;
+}
@@ -7,6 +7,10 @@
 #include <chrono>
 #include <thread>
 #include <string>
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
 
 #ifdef _WIN32
     #include <windows.h>
@@ -19,6 +23,121 @@
 
 class EyeGazeTracker {
 private:
+    /**
+     * 両目の瞳孔検出を並行に行う2レーンの作業者
+     * 左目は呼び出し側のスレッド、右目は常駐スレッドで処理し、両方が終わるまで待ち合わせる。
+     * フレームごとにスレッドを作らず、依頼と完了を世代番号で受け渡す
+     */
+    class BinocularPupilDetector {
+    private:
+        std::thread worker;
+        std::mutex mutex;
+        std::condition_variable request_ready;
+        std::condition_variable result_ready;
+        unsigned long requested;    // 依頼した世代
+        unsigned long completed;    // 常駐スレッドが処理し終えた世代
+        bool stopping;
+        bool parallel;              // 1コアなら常駐スレッドを使わず順に処理する
+
+        // 常駐スレッドへの依頼と結果（mutex で保護。処理中は呼び出し側が触れない）
+        const cv::Mat* request_roi;
+        cv::Point2f result;
+        std::exception_ptr error;
+
+        void workerLoop() {
+            unsigned long handled = 0;
+            while (true) {
+                const cv::Mat* roi;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    request_ready.wait(lock, [&] { return stopping || requested != handled; });
+                    if (stopping) {
+                        return;
+                    }
+                    handled = requested;
+                    roi = request_roi;
+                }
+
+                cv::Point2f center(-1, -1);
+                std::exception_ptr caught;
+                try {
+                    center = detectPupilCenter(*roi);
+                } catch (...) {
+                    caught = std::current_exception();
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    result = center;
+                    error = caught;
+                    completed = handled;
+                }
+                result_ready.notify_one();
+            }
+        }
+
+    public:
+        BinocularPupilDetector() : requested(0), completed(0), stopping(false),
+                                   parallel(std::thread::hardware_concurrency() > 1),
+                                   request_roi(nullptr) {
+            if (parallel) {
+                worker = std::thread(&BinocularPupilDetector::workerLoop, this);
+            }
+        }
+
+        ~BinocularPupilDetector() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            request_ready.notify_one();
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+
+        BinocularPupilDetector(const BinocularPupilDetector&) = delete;
+        BinocularPupilDetector& operator=(const BinocularPupilDetector&) = delete;
+
+        /**
+         * 左右の目の領域から瞳孔中心を求める（両方の結果が揃ってから戻る）
+         */
+        void detect(const cv::Mat& left_roi, const cv::Mat& right_roi,
+                    cv::Point2f& left_pupil, cv::Point2f& right_pupil) {
+            if (!parallel) {
+                left_pupil = detectPupilCenter(left_roi);
+                right_pupil = detectPupilCenter(right_roi);
+                return;
+            }
+
+            unsigned long generation;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                request_roi = &right_roi;
+                generation = ++requested;
+            }
+            request_ready.notify_one();
+
+            // 左目の処理で例外が出ても、右目の処理が終わるまでは戻らない（right_roi を参照中のため）
+            std::exception_ptr left_error;
+            try {
+                left_pupil = detectPupilCenter(left_roi);
+            } catch (...) {
+                left_error = std::current_exception();
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            result_ready.wait(lock, [&] { return completed == generation; });
+            right_pupil = result;
+            if (left_error) {
+                std::rethrow_exception(left_error);
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    };
+
     // OpenCV オブジェクト
     cv::VideoCapture cap;
     cv::CascadeClassifier face_cascade;
@@ -42,6 +161,28 @@ private:
     std::chrono::steady_clock::time_point last_key_time;
     const std::chrono::milliseconds KEY_COOLDOWN{500};
 
+    // 顔・目の領域追跡（初回のみ全体検出し、以降は前回位置の周辺だけを探す）
+    cv::Rect tracked_face;
+    cv::Rect tracked_left_eye;
+    cv::Rect tracked_right_eye;
+    bool has_track;
+    int frames_since_detection;
+    cv::Mat face_search_image;
+    const int REDETECT_INTERVAL = 60;            // このフレーム数ごとに全体検出で補正
+    const double FACE_SEARCH_EXPANSION = 0.25;   // 前回の顔矩形を各辺この割合だけ広げて探す
+    const double EYE_SEARCH_EXPANSION = 0.5;     // 前回の目矩形を各辺この割合だけ広げて探す
+    const double TRACKING_SCALE = 0.5;           // 追跡時の顔探索の縮小率
+    const int MIN_TRACKED_FACE_SIZE = 40;        // 縮小後にこれより小さくなる場合は縮小しない
+
+    // 検出回数の統計
+    unsigned long full_detections;
+    unsigned long tracked_frames;
+    unsigned long redetections_on_loss;
+    unsigned long redetections_periodic;
+
+    // 両目の瞳孔検出（常駐スレッドで並行に処理する）
+    BinocularPupilDetector pupil_detector;
+
 #ifdef __linux__
     Display* display;
 #endif
@@ -224,7 +365,9 @@ public:
      * コンストラクタ
      */
     EyeGazeTracker() : is_calibrated(false), up_count(0), down_count(0),
-                       left_count(0), right_count(0) {
+                       left_count(0), right_count(0), has_track(false),
+                       frames_since_detection(0), full_detections(0), tracked_frames(0),
+                       redetections_on_loss(0), redetections_periodic(0) {
         
         // 対話式カメラ初期化
         if (!initializeCameraInteractive()) {
@@ -271,6 +414,7 @@ public:
         }
         
         std::cout << "\n=== カメラ再設定 ===" << std::endl;
+        has_track = false;
         
         if (initializeCameraInteractive()) {
             optimizeCameraSettings();
@@ -286,7 +430,7 @@ public:
     /**
      * 目の領域から瞳孔中心を検出
      */
-    cv::Point2f detectPupilCenter(const cv::Mat& eye_region) {
+    static cv::Point2f detectPupilCenter(const cv::Mat& eye_region) {
         cv::Mat gray_eye, binary_eye;
 
         if (eye_region.channels() == 3) {
@@ -368,6 +512,163 @@ public:
         return eyes;
     }
 
+    /**
+     * 矩形を各辺 ratio だけ広げ、画像内に収める
+     */
+    cv::Rect expandRect(const cv::Rect& rect, double ratio, const cv::Size& bounds) {
+        int dx = cvRound(rect.width * ratio);
+        int dy = cvRound(rect.height * ratio);
+        cv::Rect expanded(rect.x - dx, rect.y - dy, rect.width + dx * 2, rect.height + dy * 2);
+        return expanded & cv::Rect(0, 0, bounds.width, bounds.height);
+    }
+
+    /**
+     * 候補の中から、期待位置に中心が最も近い矩形を選ぶ
+     */
+    bool pickClosest(const std::vector<cv::Rect>& candidates, const cv::Point2f& expected_center,
+                     cv::Rect& result) {
+        double best_distance = -1;
+        for (const auto& candidate : candidates) {
+            cv::Point2f center(candidate.x + candidate.width * 0.5f, candidate.y + candidate.height * 0.5f);
+            double distance = cv::norm(center - expected_center);
+            if (best_distance < 0 || distance < best_distance) {
+                best_distance = distance;
+                result = candidate;
+            }
+        }
+        return best_distance >= 0;
+    }
+
+    /**
+     * 前回の顔矩形の周辺だけを縮小して探す
+     */
+    bool trackFace(const cv::Mat& gray, cv::Rect& face_rect) {
+        cv::Rect window = expandRect(tracked_face, FACE_SEARCH_EXPANSION, gray.size());
+        if (window.empty()) {
+            return false;
+        }
+
+        double scale = tracked_face.width * TRACKING_SCALE >= MIN_TRACKED_FACE_SIZE ? TRACKING_SCALE : 1.0;
+        if (scale < 1.0) {
+            cv::resize(gray(window), face_search_image, cv::Size(), scale, scale, cv::INTER_AREA);
+        } else {
+            face_search_image = gray(window);
+        }
+
+        // 大きさは前回から大きく変わらないものだけを探す
+        cv::Size expected(cvRound(tracked_face.width * scale), cvRound(tracked_face.height * scale));
+        cv::Size min_size(expected.width * 7 / 10, expected.height * 7 / 10);
+        cv::Size max_size(expected.width * 14 / 10, expected.height * 14 / 10);
+
+        std::vector<cv::Rect> candidates;
+        face_cascade.detectMultiScale(face_search_image, candidates, 1.1, 3, 0, min_size, max_size);
+
+        cv::Point2f expected_center((tracked_face.x - window.x + tracked_face.width * 0.5f) * scale,
+                                    (tracked_face.y - window.y + tracked_face.height * 0.5f) * scale);
+        cv::Rect found;
+        if (!pickClosest(candidates, expected_center, found)) {
+            return false;
+        }
+
+        face_rect = cv::Rect(window.x + cvRound(found.x / scale), window.y + cvRound(found.y / scale),
+                             cvRound(found.width / scale), cvRound(found.height / scale)) &
+                    cv::Rect(0, 0, gray.cols, gray.rows);
+        return !face_rect.empty();
+    }
+
+    /**
+     * 顔の移動量だけずらした前回の目矩形の周辺を探す
+     */
+    bool trackEye(const cv::Mat& gray, const cv::Rect& previous_eye, const cv::Point& face_shift,
+                  cv::Rect& eye_rect) {
+        cv::Rect moved = previous_eye + face_shift;
+        cv::Rect window = expandRect(moved, EYE_SEARCH_EXPANSION, gray.size());
+        if (window.empty()) {
+            return false;
+        }
+
+        cv::Size min_size(std::max(15, previous_eye.width * 6 / 10), std::max(15, previous_eye.height * 6 / 10));
+        cv::Size max_size(previous_eye.width * 15 / 10, previous_eye.height * 15 / 10);
+
+        std::vector<cv::Rect> candidates;
+        eye_cascade.detectMultiScale(gray(window), candidates, 1.1, 3, 0, min_size, max_size);
+
+        cv::Point2f expected_center(moved.x - window.x + moved.width * 0.5f,
+                                    moved.y - window.y + moved.height * 0.5f);
+        cv::Rect found;
+        if (!pickClosest(candidates, expected_center, found)) {
+            return false;
+        }
+
+        eye_rect = found + window.tl();
+        return true;
+    }
+
+    /**
+     * 顔と両目の位置を求める
+     * 追跡中は前回位置の周辺だけを探し、見失ったときと一定フレームごとに全体検出する
+     * 戻り値は顔が見つかったか（目は eye_rects の要素数で判定する）
+     */
+    bool locateFaceAndEyes(const cv::Mat& gray, cv::Rect& face_rect, std::vector<cv::Rect>& eye_rects) {
+        eye_rects.clear();
+
+        if (has_track) {
+            if (frames_since_detection >= REDETECT_INTERVAL) {
+                redetections_periodic++;
+            } else {
+                cv::Rect left_eye, right_eye;
+                bool tracked = trackFace(gray, face_rect);
+                if (tracked) {
+                    cv::Point face_shift = face_rect.tl() - tracked_face.tl();
+                    tracked = trackEye(gray, tracked_left_eye, face_shift, left_eye) &&
+                              trackEye(gray, tracked_right_eye, face_shift, right_eye) &&
+                              left_eye.x < right_eye.x;
+                }
+
+                if (tracked) {
+                    tracked_frames++;
+                    frames_since_detection++;
+                    tracked_face = face_rect;
+                    tracked_left_eye = left_eye;
+                    tracked_right_eye = right_eye;
+                    eye_rects.push_back(left_eye);
+                    eye_rects.push_back(right_eye);
+                    return true;
+                }
+
+                // 追跡の信頼度が落ちたので、このフレームで全体検出し直す
+                redetections_on_loss++;
+            }
+        }
+
+        full_detections++;
+        frames_since_detection = 0;
+        has_track = false;
+
+        std::vector<cv::Rect> faces;
+        face_cascade.detectMultiScale(gray, faces, 1.1, 3, 0, cv::Size(30, 30));
+        if (faces.empty()) {
+            return false;
+        }
+
+        face_rect = faces[0];
+        eye_rects = extractEyeRegions(gray(face_rect), face_rect);
+        if (eye_rects.size() >= 2) {
+            has_track = true;
+            tracked_face = face_rect;
+            tracked_left_eye = eye_rects[0];
+            tracked_right_eye = eye_rects[1];
+        }
+        return true;
+    }
+
+    void printDetectionStats() const {
+        std::cout << "検出統計: 全体検出 " << full_detections
+                  << " 回 (見失い " << redetections_on_loss
+                  << " / 定期 " << redetections_periodic
+                  << "), 追跡 " << tracked_frames << " フレーム" << std::endl;
+    }
+
     void calibrate(const cv::Point2f& left_pupil, const cv::Point2f& right_pupil) {
         baseline_left_pupil = left_pupil;
         baseline_right_pupil = right_pupil;
@@ -485,16 +786,13 @@ public:
 
             cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
 
-            std::vector<cv::Rect> faces;
-            face_cascade.detectMultiScale(gray, faces, 1.1, 3, 0, cv::Size(30, 30));
+            cv::Rect face_rect;
+            std::vector<cv::Rect> eye_rects;
+            bool face_found = locateFaceAndEyes(gray, face_rect, eye_rects);
 
-            if (!faces.empty()) {
-                cv::Rect face_rect = faces[0];
+            if (face_found) {
                 cv::rectangle(frame, face_rect, cv::Scalar(255, 0, 0), 2);
 
-                cv::Mat face_roi = gray(face_rect);
-                std::vector<cv::Rect> eye_rects = extractEyeRegions(face_roi, face_rect);
-
                 if (eye_rects.size() >= 2) {
                     cv::Rect left_eye_rect = eye_rects[0];
                     cv::Rect right_eye_rect = eye_rects[1];
@@ -512,8 +810,8 @@ public:
                     cv::Mat left_eye_roi = frame(left_eye_rect);
                     cv::Mat right_eye_roi = frame(right_eye_rect);
 
-                    cv::Point2f left_pupil = detectPupilCenter(left_eye_roi);
-                    cv::Point2f right_pupil = detectPupilCenter(right_eye_roi);
+                    cv::Point2f left_pupil, right_pupil;
+                    pupil_detector.detect(left_eye_roi, right_eye_roi, left_pupil, right_pupil);
 
                     if (left_pupil.x >= 0 && right_pupil.x >= 0) {
                         left_pupil.x += left_eye_rect.x;
@@ -545,6 +843,11 @@ public:
             cv::putText(frame, "FPS: " + std::to_string((int)fps), cv::Point(10, 60), 
                        cv::FONT_HERSHEY_SIMPLEX, 0.8, cv::Scalar(255, 255, 255), 2);
 
+            std::string detection = has_track ? "Tracking" : "Detecting";
+            detection += " (full: " + std::to_string(full_detections) + ")";
+            cv::putText(frame, detection, cv::Point(10, 120), 
+                       cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
+
             // 操作説明を追加
             cv::putText(frame, "Press 'r' to reconfigure camera", cv::Point(10, 90), 
                        cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
@@ -557,12 +860,8 @@ public:
             } else if (key == 'r') {
                 // カメラ再設定
                 reconfigureCamera();
-            } else if (key == 'c' && !faces.empty()) {
-                // キャリブレーション実行
-                cv::Rect face_rect = faces[0];
-                cv::Mat face_roi = gray(face_rect);
-                std::vector<cv::Rect> eye_rects = extractEyeRegions(face_roi, face_rect);
-
+            } else if (key == 'c' && face_found) {
+                // キャリブレーション実行（このフレームで求めた目の領域を使う）
                 if (eye_rects.size() >= 2) {
                     cv::Rect left_eye_rect = eye_rects[0];
                     cv::Rect right_eye_rect = eye_rects[1];
@@ -570,8 +869,8 @@ public:
                     cv::Mat left_eye_roi = frame(left_eye_rect);
                     cv::Mat right_eye_roi = frame(right_eye_rect);
 
-                    cv::Point2f left_pupil = detectPupilCenter(left_eye_roi);
-                    cv::Point2f right_pupil = detectPupilCenter(right_eye_roi);
+                    cv::Point2f left_pupil, right_pupil;
+                    pupil_detector.detect(left_eye_roi, right_eye_roi, left_pupil, right_pupil);
 
                     if (left_pupil.x >= 0 && right_pupil.x >= 0) {
                         left_pupil.x += left_eye_rect.x;
@@ -585,6 +884,7 @@ public:
             }
         }
 
+        printDetectionStats();
         cap.release();
         cv::destroyAllWindows();
     }
@@ -0,0 +1,410 @@
+// 録画済みのセッションをまとめて解析し、フレームごとの結果と瞬き・視線のイベントを書き出すツール
+// 1ファイルを1ワーカーが受け持ち（共有プールでコア数分を並列に処理）、ファイルごとのデコードスレッドが先読みする
+#include "BlinkDetector.h"
+#include "Config.h"
+#include "FramePool.h"
+#include "GazeEstimator.h"
+#include "PreprocessCache.h"
+#include "PupilTracker.h"
+#include "ReplaySource.h"
+#include "SPSCQueue.h"
+#include "WorkStealingPool.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct BatchOptions {
+    std::vector<std::string> inputs;
+    std::string output_dir = "batch_out";
+    std::string config_path;
+    size_t workers = 0;       // 0 ならコア数
+    size_t decode_ahead = 8;  // ファイルごとに先読みするフレーム数
+    bool csv = false;         // フレームごとの結果を CSV で書く（既定はバイナリ）
+};
+
+// フレームごとの結果ファイル（.frames.bin）のヘッダ
+struct FramesFileHeader {
+    char magic[8];        // "EYEFRMS"
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t frame_count;
+    double fps;
+};
+
+// 1フレーム分の結果（32 バイト、リトルエンディアン）
+struct FrameRecord {
+    uint32_t frame;
+    float time_ms;        // 記録上の時刻
+    float pupil_x;        // 見つからなければ -1
+    float pupil_y;
+    float ear;
+    float gaze_x;         // 基準位置からの視線方向（未較正なら 0）
+    float gaze_y;
+    uint8_t flags;        // FLAG_*
+    uint8_t track_state;  // PupilTrackState
+    uint8_t gesture;      // BlinkGesture
+    uint8_t reserved;
+};
+
+static_assert(sizeof(FramesFileHeader) == 32, "frames file header must stay 32 bytes");
+static_assert(sizeof(FrameRecord) == 32, "frame record must stay 32 bytes");
+
+const char FRAMES_MAGIC[8] = "EYEFRMS";
+const uint32_t FRAMES_VERSION = 1;
+
+const uint8_t FLAG_PUPIL_FOUND = 1 << 0;
+const uint8_t FLAG_BLINK = 1 << 1;
+const uint8_t FLAG_DOUBLE_BLINK = 1 << 2;
+const uint8_t FLAG_CALIBRATED = 1 << 3;
+
+// 視線の向きのイベントにする閾値（コマンドモードの方向コマンドと同じ）
+const double GAZE_EVENT_MAGNITUDE = 0.3;
+// 先読みのキューが空・満杯のときの待ち
+const std::chrono::microseconds QUEUE_WAIT(200);
+
+struct FileResult {
+    std::string input;
+    std::string output_stem;
+    bool ok = false;
+    std::string error;
+    uint64_t frames = 0;
+    uint64_t events = 0;
+    double seconds = 0.0;
+};
+
+// フレームごとの結果の書き出し（バイナリは最後にヘッダのフレーム数を書き直す）
+class FrameWriter {
+private:
+    std::ofstream out;
+    bool csv;
+    uint64_t count;
+    double fps;
+
+public:
+    FrameWriter(const std::string& path, bool write_csv, double frame_rate)
+        : out(path, write_csv ? std::ios::out : std::ios::out | std::ios::binary),
+          csv(write_csv), count(0), fps(frame_rate) {
+        if (!out.is_open()) {
+            return;
+        }
+        if (csv) {
+            out << "frame,time_ms,pupil_found,pupil_x,pupil_y,ear,gaze_x,gaze_y,blink,double_blink,calibrated,track_state,gesture\n";
+            out << std::fixed << std::setprecision(3);
+        } else {
+            writeHeader();
+        }
+    }
+    
+    bool isOpen() const { return out.is_open(); }
+    
+    void write(const FrameRecord& record) {
+        count++;
+        if (!csv) {
+            out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+            return;
+        }
+        out << record.frame << ',' << record.time_ms << ',' << ((record.flags & FLAG_PUPIL_FOUND) ? 1 : 0) << ','
+            << record.pupil_x << ',' << record.pupil_y << ',' << record.ear << ','
+            << record.gaze_x << ',' << record.gaze_y << ','
+            << ((record.flags & FLAG_BLINK) ? 1 : 0) << ',' << ((record.flags & FLAG_DOUBLE_BLINK) ? 1 : 0) << ','
+            << ((record.flags & FLAG_CALIBRATED) ? 1 : 0) << ','
+            << static_cast<int>(record.track_state) << ',' << static_cast<int>(record.gesture) << '\n';
+    }
+    
+    bool finish() {
+        if (!csv) {
+            out.seekp(0);
+            writeHeader();
+        }
+        out.close();
+        return !out.fail();
+    }
+
+private:
+    void writeHeader() {
+        FramesFileHeader header;
+        std::memcpy(header.magic, FRAMES_MAGIC, sizeof(header.magic));
+        header.version = FRAMES_VERSION;
+        header.record_size = sizeof(FrameRecord);
+        header.frame_count = count;
+        header.fps = fps;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+};
+
+const char* gazeZone(const cv::Point2f& direction, bool calibrated) {
+    if (!calibrated || std::sqrt(direction.x * direction.x + direction.y * direction.y) <= GAZE_EVENT_MAGNITUDE) {
+        return "center";
+    }
+    if (std::abs(direction.x) > std::abs(direction.y)) {
+        return direction.x > 0 ? "right" : "left";
+    }
+    return direction.y > 0 ? "down" : "up";
+}
+
+// 1ファイルを解析する（ワーカーの中で呼ぶ）
+FileResult analyzeFile(const std::string& input, const std::string& output_stem,
+                       const BatchOptions& options, const EyeTrackingConfig& config) {
+    FileResult result;
+    result.input = input;
+    result.output_stem = output_stem;
+    auto start = std::chrono::steady_clock::now();
+    
+    ReplaySource source;
+    if (!source.open(input, ReplayPacing::AsFastAsPossible)) {
+        result.error = "cannot open";
+        return result;
+    }
+    
+    std::string base = options.output_dir + "/" + output_stem;
+    FrameWriter frames(base + (options.csv ? ".frames.csv" : ".frames.bin"), options.csv, source.fps());
+    std::ofstream events(base + ".events.csv");
+    if (!frames.isOpen() || !events.is_open()) {
+        result.error = "cannot create output in " + options.output_dir;
+        return result;
+    }
+    events << "frame,time_ms,event,value\n" << std::fixed << std::setprecision(3);
+    
+    // デコードは専用スレッドで先読みし、解析はワーカーのスレッドで行う
+    FramePool pool(options.decode_ahead + 2, source.frameSize());
+    SPSCQueue<FramePacketPtr> decoded(options.decode_ahead);
+    std::atomic<bool> decode_finished(false);
+    std::atomic<bool> cancelled(false);
+    std::thread decoder([&] {
+        while (!cancelled) {
+            FramePacketPtr packet = pool.acquire();
+            if (!packet) {
+                std::this_thread::sleep_for(QUEUE_WAIT);
+                continue;
+            }
+            if (!source.read(packet->frame, packet->capture_time)) {
+                break;
+            }
+            while (!cancelled && !decoded.tryPush(packet)) {
+                std::this_thread::sleep_for(QUEUE_WAIT);
+            }
+        }
+        decode_finished = true;
+    });
+    
+    BlinkDetector blink_detector;
+    GazeEstimator gaze_estimator;
+    blink_detector.configure(config.blink);
+    gaze_estimator.configure(config.gaze);
+    PupilTracker pupil_tracker;
+    PreprocessCache cache;
+    
+    bool was_found = false;
+    std::string zone = "center";
+    FramePacketPtr packet;
+    
+    while (true) {
+        if (!decoded.tryPop(packet)) {
+            if (decode_finished && decoded.empty()) {
+                break;
+            }
+            std::this_thread::sleep_for(QUEUE_WAIT);
+            continue;
+        }
+        
+        FrameAnalysis analysis;
+        analysis.timestamp = packet->capture_time;
+        cache.reset(packet->frame);
+        analysis.pupil_center = pupil_tracker.track(cache, analysis.timestamp, gaze_estimator);
+        analysis.pupil_found = analysis.pupil_center.x >= 0 && analysis.pupil_center.y >= 0;
+        analysis.pupil_track_state = pupil_tracker.state();
+        analysis.pupil_window_confirmed = pupil_tracker.confirmedByWindow();
+        analysis.ear = blink_detector.calculateOpenness(cache);
+        blink_detector.detectBlink(analysis);
+        
+        // 視線の基準は最初に瞳孔が見つかった位置（録画の冒頭で正面を見ている前提）
+        if (analysis.pupil_found && !gaze_estimator.isCalibrated()) {
+            gaze_estimator.calibrateBaseline(analysis.pupil_center, packet->frame.size());
+        }
+        bool calibrated = gaze_estimator.isCalibrated();
+        analysis.gaze_direction = gaze_estimator.calculateGazeDirection(analysis.pupil_center);
+        
+        FrameRecord record = {};
+        record.frame = static_cast<uint32_t>(result.frames);
+        // 再生のタイムスタンプは記録上の時刻（先頭からの経過）
+        record.time_ms = static_cast<float>(std::chrono::duration<double, std::milli>(
+            analysis.timestamp.time_since_epoch()).count());
+        record.pupil_x = analysis.pupil_center.x;
+        record.pupil_y = analysis.pupil_center.y;
+        record.ear = static_cast<float>(analysis.ear);
+        record.gaze_x = analysis.gaze_direction.x;
+        record.gaze_y = analysis.gaze_direction.y;
+        record.flags = (analysis.pupil_found ? FLAG_PUPIL_FOUND : 0) |
+                       (analysis.blink_detected ? FLAG_BLINK : 0) |
+                       (analysis.double_blink ? FLAG_DOUBLE_BLINK : 0) |
+                       (calibrated ? FLAG_CALIBRATED : 0);
+        record.track_state = static_cast<uint8_t>(analysis.pupil_track_state);
+        record.gesture = static_cast<uint8_t>(analysis.gesture);
+        frames.write(record);
+        
+        // 状態が変わったフレームだけイベントとして残す
+        auto event = [&](const char* name, const char* value) {
+            events << record.frame << ',' << record.time_ms << ',' << name << ',' << value << '\n';
+            result.events++;
+        };
+        if (analysis.blink_detected) {
+            event("blink", "");
+        }
+        if (analysis.gesture != BlinkGesture::None) {
+            event("gesture", BlinkGestureRecognizer::gestureName(analysis.gesture));
+        }
+        if (analysis.pupil_found != was_found) {
+            event(analysis.pupil_found ? "pupil_found" : "pupil_lost", "");
+            was_found = analysis.pupil_found;
+        }
+        // 瞳孔を見失ったフレーム（瞬き中など）では向きを変えない
+        const char* current_zone = gazeZone(analysis.gaze_direction, calibrated);
+        if (analysis.pupil_found && zone != current_zone) {
+            event("gaze", current_zone);
+            zone = current_zone;
+        }
+        
+        packet.reset();
+        result.frames++;
+    }
+    
+    cancelled = true;
+    decoder.join();
+    
+    events.close();
+    result.ok = frames.finish() && !events.fail();
+    if (!result.ok) {
+        result.error = "failed to write output";
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+// 出力ファイル名（入力のファイル名。重複すれば番号を付ける）
+std::vector<std::string> outputStems(const std::vector<std::string>& inputs) {
+    std::vector<std::string> stems;
+    std::set<std::string> used;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        std::filesystem::path path(inputs[i]);
+        std::string stem = path.has_stem() ? path.stem().string() : path.parent_path().filename().string();
+        if (stem.empty() || used.count(stem)) {
+            stem += "_" + std::to_string(i);
+        }
+        used.insert(stem);
+        stems.push_back(stem);
+    }
+    return stems;
+}
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options] <video|image_dir>...\n"
+              << "  --output <dir>        output directory (default batch_out)\n"
+              << "  --workers <n>         files analysed in parallel (default: core count)\n"
+              << "  --decode-ahead <n>    frames decoded ahead per file (default 8)\n"
+              << "  --config <path>       detection settings (config.xml)\n"
+              << "  --csv                 write per-frame results as CSV instead of binary\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    BatchOptions options;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--output" && has_value) {
+            options.output_dir = argv[++i];
+        } else if (arg == "--workers" && has_value) {
+            options.workers = static_cast<size_t>(std::max(0, std::stoi(argv[++i])));
+        } else if (arg == "--decode-ahead" && has_value) {
+            options.decode_ahead = static_cast<size_t>(std::max(1, std::stoi(argv[++i])));
+        } else if (arg == "--config" && has_value) {
+            options.config_path = argv[++i];
+        } else if (arg == "--csv") {
+            options.csv = true;
+        } else if (!arg.empty() && arg[0] != '-') {
+            options.inputs.push_back(arg);
+        } else {
+            printUsage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : -1;
+        }
+    }
+    if (options.inputs.empty()) {
+        printUsage(argv[0]);
+        return -1;
+    }
+    
+    EyeTrackingConfig config;
+    if (!options.config_path.empty()) {
+        std::string error;
+        if (!ConfigLoader::load(options.config_path, config, error)) {
+            std::cerr << error << std::endl;
+            return -1;
+        }
+    }
+    
+    std::error_code ec;
+    std::filesystem::create_directories(options.output_dir, ec);
+    
+    // ファイル単位で並列にするため、OpenCV 内部の並列化は止める
+    cv::setNumThreads(1);
+    
+    std::vector<std::string> stems = outputStems(options.inputs);
+    std::vector<FileResult> results(options.inputs.size());
+    std::mutex done_mutex;
+    std::condition_variable done;
+    size_t remaining = options.inputs.size();
+    
+    auto start = std::chrono::steady_clock::now();
+    size_t worker_count = 0;
+    {
+        WorkStealingPool pool(options.workers);
+        worker_count = pool.threadCount();
+        for (size_t i = 0; i < options.inputs.size(); i++) {
+            pool.submit([&, i] {
+                results[i] = analyzeFile(options.inputs[i], stems[i], options, config);
+                std::lock_guard<std::mutex> lock(done_mutex);
+                remaining--;
+                done.notify_one();
+            });
+        }
+        std::unique_lock<std::mutex> lock(done_mutex);
+        done.wait(lock, [&] { return remaining == 0; });
+    }
+    double total_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    uint64_t total_frames = 0;
+    int failures = 0;
+    for (const auto& result : results) {
+        if (!result.ok) {
+            std::cerr << result.input << ": " << result.error << std::endl;
+            failures++;
+            continue;
+        }
+        total_frames += result.frames;
+        std::cout << result.input << " -> " << result.output_stem << ": " << result.frames << " frames, "
+                  << result.events << " events, "
+                  << (result.seconds > 0 ? result.frames / result.seconds : 0) << " frames/s" << std::endl;
+    }
+    std::cout << "Analysed " << (results.size() - failures) << "/" << results.size() << " files, "
+              << total_frames << " frames in " << total_s << " s on " << worker_count << " workers: "
+              << (total_s > 0 ? total_frames / total_s : 0) << " frames/s" << std::endl;
+    return failures == 0 ? 0 : 1;
+}